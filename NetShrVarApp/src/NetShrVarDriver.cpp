@@ -97,6 +97,25 @@ asynStatus NetShrVarDriver::readValue(asynUser *pasynUser, const char* functionN
 	}
 }
 
+/// the configured type of the parameter being accessed, or an empty string if this is not known
+/// (writeValue() or writeArrayValue() will then report the error)
+std::string NetShrVarDriver::paramType(asynUser *pasynUser)
+{
+	const char *paramName = NULL;
+	if (m_netvarint == NULL || getParamName(pasynUser->reason, &paramName) != asynSuccess || paramName == NULL)
+	{
+		return "";
+	}
+	try
+	{
+		return m_netvarint->paramType(paramName);
+	}
+	catch(const std::exception&)
+	{
+		return "";
+	}
+}
+
 /// write an array to the driver
 /// @tparam T Data type of \a value
 /// @param[in] pasynUser pointer to AsynUser instance
@@ -134,8 +153,16 @@ asynStatus NetShrVarDriver::writeArrayValue(asynUser *pasynUser, const char* fun
 /// write a float to the driver
 /// @param[in] pasynUser pointer to AsynUser instance
 /// @param[in] value Value to write
+/// a float32 parameter is written to the shared variable as a CNVSingle, the asyn parameter is then set to the
+/// single precision value actually written
 asynStatus NetShrVarDriver::writeFloat64(asynUser *pasynUser, epicsFloat64 value)
 {
+	if (paramType(pasynUser) == "float32")
+	{
+		float fvalue = static_cast<float>(value);
+		asynStatus status = writeValue(pasynUser, "writeFloat64", fvalue);
+		return (status == asynSuccess ? asynPortDriver::writeFloat64(pasynUser, fvalue) : status);
+	}
 	asynStatus status = writeValue(pasynUser, "writeFloat64", value);
 	return (status == asynSuccess ? asynPortDriver::writeFloat64(pasynUser, value) : status);
 }
@@ -146,6 +173,22 @@ asynStatus NetShrVarDriver::writeInt32(asynUser *pasynUser, epicsInt32 value)
 	return (status == asynSuccess ? asynPortDriver::writeInt32(pasynUser, value) : status);
 }
 
+/// asyn does not have unsigned types, so a uint64 parameter is passed as int64 and 
+/// written to the shared variable as a CNVUInt64 with the same bit pattern
+asynStatus NetShrVarDriver::writeInt64(asynUser *pasynUser, epicsInt64 value)
+{
+	asynStatus status;
+	if (paramType(pasynUser) == "uint64")
+	{
+		status = writeValue(pasynUser, "writeInt64", static_cast<unsigned __int64>(value));
+	}
+	else
+	{
+		status = writeValue(pasynUser, "writeInt64", static_cast<__int64>(value));
+	}
+	return (status == asynSuccess ? asynPortDriver::writeInt64(pasynUser, value) : status);
+}
+
 asynStatus NetShrVarDriver::readFloat64(asynUser *pasynUser, epicsFloat64 *value)
 {
 	static const char* functionName = "readFloat64";
@@ -180,6 +223,23 @@ asynStatus NetShrVarDriver::readInt32(asynUser *pasynUser, epicsInt32 *value)
 	return status;
 }
 
+asynStatus NetShrVarDriver::readInt64(asynUser *pasynUser, epicsInt64 *value)
+{
+	static const char* functionName = "readInt64";
+	int function = pasynUser->reason;
+	const char *paramName = NULL;
+	getParamName(function, &paramName);
+	asynStatus status = readValue(pasynUser, functionName);
+	if (status == asynSuccess)
+	{
+		asynPortDriver::readInt64(pasynUser, value);
+		asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
+				"%s:%s: function=%d, name=%s, value=%lld\n", 
+				driverName, functionName, function, paramName, static_cast<long long>(*value));
+	}
+	return status;
+}
+
 asynStatus NetShrVarDriver::readOctet(asynUser *pasynUser, char *value, size_t maxChars, size_t *nActual, int *eomReason)
 {
 	static const char *functionName = "readOctet";
@@ -189,25 +249,23 @@ asynStatus NetShrVarDriver::readOctet(asynUser *pasynUser, char *value, size_t m
 	asynStatus status = readValue(pasynUser, functionName);
 	if (status == asynSuccess)
 	{
-		std::string value_s;
-		getStringParam(function, value_s);
-		if ( value_s.size() > maxChars ) // did we read more than we have space for?
+		// copy straight from the value cached by m_netvarint, so there is no length limit and no temporary string
+		size_t nAvailable = 0;
+		m_netvarint->readStringValue(paramName, value, maxChars, nActual, &nAvailable);
+		if ( nAvailable > maxChars ) // did we read more than we have space for?
 		{
-			*nActual = maxChars;
 			if (eomReason) { *eomReason = ASYN_EOM_CNT | ASYN_EOM_END; }
 			asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
-				"%s:%s: function=%d, name=%s, value=\"%s\" (TRUNCATED from %d chars)\n", 
-				driverName, functionName, function, paramName, value_s.substr(0,*nActual).c_str(), value_s.size());
+				"%s:%s: function=%d, name=%s, value=\"%.*s\" (TRUNCATED from %d chars)\n", 
+				driverName, functionName, function, paramName, (int)*nActual, value, (int)nAvailable);
 		}
 		else
 		{
-			*nActual = value_s.size();
 			if (eomReason) { *eomReason = ASYN_EOM_END; }
 			asynPrint(pasynUser, ASYN_TRACEIO_DRIVER, 
-				"%s:%s: function=%d, name=%s, value=\"%s\"\n", 
-				driverName, functionName, function, paramName, value_s.c_str());
+				"%s:%s: function=%d, name=%s, value=\"%.*s\"\n", 
+				driverName, functionName, function, paramName, (int)*nActual, value);
 		}
-		strncpy(value, value_s.c_str(), maxChars); // maxChars  will NULL pad if possible, change to  *nActual  if we do not want this
 	}
 	else
 	{
@@ -264,6 +322,11 @@ asynStatus NetShrVarDriver::readInt32Array(asynUser *pasynUser, epicsInt32 *valu
 	return readArrayValue(pasynUser, "readInt32Array", value, nElements, nIn);
 }
 
+asynStatus NetShrVarDriver::readInt64Array(asynUser *pasynUser, epicsInt64 *value, size_t nElements, size_t *nIn)
+{
+	return readArrayValue(pasynUser, "readInt64Array", value, nElements, nIn);
+}
+
 asynStatus NetShrVarDriver::readInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements, size_t *nIn)
 {
 	return readArrayValue(pasynUser, "readInt16Array", value, nElements, nIn);
@@ -311,6 +374,15 @@ asynStatus NetShrVarDriver::writeInt32Array(asynUser *pasynUser, epicsInt32 *val
     return writeArrayValue(pasynUser, "writeInt32Array", value, nElements);
 }
 
+asynStatus NetShrVarDriver::writeInt64Array(asynUser *pasynUser, epicsInt64 *value, size_t nElements)
+{
+	if (paramType(pasynUser) == "uint64array")
+	{
+		return writeArrayValue(pasynUser, "writeInt64Array", reinterpret_cast<unsigned __int64*>(value), nElements);
+	}
+    return writeArrayValue(pasynUser, "writeInt64Array", reinterpret_cast<__int64*>(value), nElements);
+}
+
 asynStatus NetShrVarDriver::writeInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements)
 {
     return writeArrayValue(pasynUser, "writeInt16Array", value, nElements);
@@ -331,6 +403,28 @@ asynStatus NetShrVarDriver::writeFloat32Array(asynUser *pasynUser, epicsFloat32
     return writeArrayValue(pasynUser, "writeFloat32Array", value, nElements);
 }
 
+/// Called when a record is connected to a parameter, we use this to create sub array parameters
+/// on demand if \a drvInfo is of the form  name[index]  or  name[start:length] 
+asynStatus NetShrVarDriver::drvUserCreate(asynUser *pasynUser, const char *drvInfo, const char **pptypeName, size_t *psize)
+{
+	static const char* functionName = "drvUserCreate";
+	int index;
+	if (m_netvarint != NULL && drvInfo != NULL && strchr(drvInfo, '[') != NULL && findParam(drvInfo, &index) != asynSuccess)
+	{
+		try
+		{
+			m_netvarint->createSubArrayParam(drvInfo);
+		}
+		catch(const std::exception& ex)
+		{
+			epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize, 
+				"%s:%s: drvInfo=%s, error=%s", driverName, functionName, drvInfo, ex.what());
+			return asynError;
+		}
+	}
+	return asynPortDriver::drvUserCreate(pasynUser, drvInfo, pptypeName, psize);
+}
+
 /// EPICS driver report function for iocsh dbior command
 void NetShrVarDriver::report(FILE* fp, int details)
 {
@@ -358,8 +452,8 @@ NetShrVarDriver::NetShrVarDriver(NetShrVarInterface* netvarint, int poll_ms, con
 	: asynPortDriver(portName, 
 	0, /* maxAddr */ 
 	static_cast<int>(netvarint->nParams()),
-	asynInt32Mask | asynInt8ArrayMask | asynInt16ArrayMask | asynInt32ArrayMask | asynFloat64Mask | asynFloat32ArrayMask | asynFloat64ArrayMask | asynOctetMask | asynDrvUserMask, /* Interface mask */
-	asynInt32Mask | asynInt8ArrayMask | asynInt16ArrayMask | asynInt32ArrayMask | asynFloat64Mask | asynFloat32ArrayMask | asynFloat64ArrayMask | asynOctetMask,  /* Interrupt mask */
+	asynInt32Mask | asynInt64Mask | asynInt8ArrayMask | asynInt16ArrayMask | asynInt32ArrayMask | asynInt64ArrayMask | asynFloat64Mask | asynFloat32ArrayMask | asynFloat64ArrayMask | asynOctetMask | asynDrvUserMask, /* Interface mask */
+	asynInt32Mask | asynInt64Mask | asynInt8ArrayMask | asynInt16ArrayMask | asynInt32ArrayMask | asynInt64ArrayMask | asynFloat64Mask | asynFloat32ArrayMask | asynFloat64ArrayMask | asynOctetMask,  /* Interrupt mask */
 	ASYN_CANBLOCK, /* asynFlags.  This driver can block but it is not multi-device */
 	1, /* Autoconnect */
 	0, /* Default priority */
@@ -456,6 +550,30 @@ extern "C" {
 		}
 	}
 
+	/// EPICS iocsh callable function to re-read the XML configuration file of an existing port, 
+	/// see NetShrVarInterface::reloadConfig(). The function is registered via NetShrVarRegister().
+	///
+	/// @param[in] portName @copydoc initArg0
+	int NetShrVarReload(const char *portName)
+	{
+		try
+		{
+			NetShrVarDriver* driver = dynamic_cast<NetShrVarDriver*>(static_cast<asynPortDriver*>(findAsynPortDriver(portName)));
+			if (driver == NULL)
+			{
+				errlogSevPrintf(errlogMajor, "NetShrVarReload failed: \"%s\" is not a NetShrVar port\n", (portName != NULL ? portName : ""));
+				return(asynError);
+			}
+			driver->reloadConfig();
+			return(asynSuccess);
+		}
+		catch(const std::exception& ex)
+		{
+			errlogSevPrintf(errlogMajor, "NetShrVarReload failed: %s\n", ex.what());
+			return(asynError);
+		}
+	}
+
 	// EPICS iocsh shell commands 
 
 	static const iocshArg initArg0 = { "portName", iocshArgString};			///< The name of the asyn driver port we will create
@@ -477,10 +595,20 @@ extern "C" {
 		NetShrVarConfigure(args[0].sval, args[1].sval, args[2].sval, args[3].ival, args[4].ival);
 	}
 	
+	static const iocshArg * const reloadArgs[] = { &initArg0 };
+
+	static const iocshFuncDef reloadFuncDef = {"NetShrVarReload", sizeof(reloadArgs) / sizeof(iocshArg*), reloadArgs};
+
+	static void reloadCallFunc(const iocshArgBuf *args)
+	{
+		NetShrVarReload(args[0].sval);
+	}
+	
 	/// Register new commands with EPICS IOC shell
 	static void NetShrVarRegister(void)
 	{
 		iocshRegister(&initFuncDef, initCallFunc);
+		iocshRegister(&reloadFuncDef, reloadCallFunc);
 	}
 
 	epicsExportRegistrar(NetShrVarRegister);
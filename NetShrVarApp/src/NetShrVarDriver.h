@@ -23,14 +23,17 @@ public:
 
 	// These are the methods that we override from asynPortDriver
 	virtual asynStatus writeInt32(asynUser *pasynUser, epicsInt32 value);
+	virtual asynStatus writeInt64(asynUser *pasynUser, epicsInt64 value);
 	virtual asynStatus writeFloat64(asynUser *pasynUser, epicsFloat64 value);
 	virtual asynStatus writeOctet(asynUser *pasynUser, const char *value, size_t maxChars, size_t *nActual);
 	virtual asynStatus writeInt8Array(asynUser *pasynUser, epicsInt8 *value, size_t nElements); 
 	virtual asynStatus writeInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements); 
 	virtual asynStatus writeInt32Array(asynUser *pasynUser, epicsInt32 *value, size_t nElements); 
+	virtual asynStatus writeInt64Array(asynUser *pasynUser, epicsInt64 *value, size_t nElements); 
 	virtual asynStatus writeFloat32Array(asynUser *pasynUser, epicsFloat32 *value, size_t nElements); 
 	virtual asynStatus writeFloat64Array(asynUser *pasynUser, epicsFloat64 *value, size_t nElements); 
 	virtual asynStatus readInt32(asynUser *pasynUser, epicsInt32 *value);
+	virtual asynStatus readInt64(asynUser *pasynUser, epicsInt64 *value);
 	virtual asynStatus readFloat64(asynUser *pasynUser, epicsFloat64 *value);
 	virtual asynStatus readOctet(asynUser *pasynUser, char *value, size_t maxChars, size_t *nActual, int *eomReason);
 	virtual asynStatus readFloat32Array(asynUser *pasynUser, epicsFloat32 *value, size_t nElements, size_t *nIn);
@@ -38,12 +41,18 @@ public:
 	virtual asynStatus readInt8Array(asynUser *pasynUser, epicsInt8 *value, size_t nElements, size_t *nIn);
 	virtual asynStatus readInt16Array(asynUser *pasynUser, epicsInt16 *value, size_t nElements, size_t *nIn);
 	virtual asynStatus readInt32Array(asynUser *pasynUser, epicsInt32 *value, size_t nElements, size_t *nIn);
+	virtual asynStatus readInt64Array(asynUser *pasynUser, epicsInt64 *value, size_t nElements, size_t *nIn);
+	virtual asynStatus drvUserCreate(asynUser *pasynUser, const char *drvInfo, const char **pptypeName, size_t *psize);
 	virtual void report(FILE* fp, int details);
 	int pollTime() { return m_poll_ms; }
 	void updateValues()
 	{
 		m_netvarint->updateValues();
 	}	
+	void reloadConfig()
+	{
+		m_netvarint->reloadConfig();
+	}
 	static void epicsExitFunc(void* arg);
 	void shuttingDown(bool state) { m_shutting_down = state; }
 	bool shuttingDown() { return m_shutting_down; }
@@ -54,6 +63,7 @@ private:
 	bool m_shutting_down;
 
 	asynStatus readValue(asynUser *pasynUser, const char* functionName);
+	std::string paramType(asynUser *pasynUser);
 	template<typename T> asynStatus writeValue(asynUser *pasynUser, const char* functionName, T value);
 	template<typename T> asynStatus writeArrayValue(asynUser *pasynUser, const char* functionName, T *value, size_t nElements);
 	template<typename T> asynStatus readArrayValue(asynUser *pasynUser, const char* functionName, T *value, size_t nElements, size_t *nIn);
@@ -24,6 +24,7 @@
 #include <vector>
 #include <map>
 #include <list>
+#include <deque>
 #include <stdexcept>
 #include <sstream>
 #include <fstream>
@@ -39,6 +40,7 @@
 #include <shareLib.h>
 #include <macLib.h>
 #include <epicsGuard.h>
+#include <epicsEvent.h>
 #include <epicsString.h>
 #include <errlog.h>
 #include <cantProceed.h>
@@ -53,6 +55,11 @@
 
 #include "NetShrVarInterface.h"
 #include "cnvconvert.h"
+#include "arraystats.h"
+#include "arrayconvert.h"
+#include "configcache.h"
+#include "dispatcher.h"
+#include "latency.h"
 
 #define MAX_PATH_LEN 256
 
@@ -82,13 +89,6 @@ public:
 	    throw NetShrVarException(__func, __code); \
 	}
 
-#define ERROR_PRINT_CONTINUE(__func, __code) \
-    if (__code < 0) \
-	{ \
-	    std::cerr << NetShrVarException::ni_message(__func, __code); \
-		continue; \
-	}
-
 /// connection status of a network shared variable
 static const char* connectionStatus(CNVConnectionStatus status)
 {
@@ -109,21 +109,28 @@ static const char* connectionStatus(CNVConnectionStatus status)
 		}
 }
 
-/// A CNVData item that automatically "disposes" itself
+/// A CNVData item that automatically "disposes" itself. Only one ScopedCNVData can own a given CNVData, 
+/// so it cannot be copied - ownership is passed on by std::move(), release() or reset()
 class ScopedCNVData
 {
 	CNVData m_value;	
+	ScopedCNVData(const ScopedCNVData&);
+	ScopedCNVData& operator=(const ScopedCNVData&);
 	public:
-	ScopedCNVData(const CNVData& d) : m_value(d) { }
+	explicit ScopedCNVData(CNVData d) : m_value(d) { }
 	ScopedCNVData() : m_value(0) { }
-	ScopedCNVData(const ScopedCNVData& d) : m_value(d.m_value) { }
-	CNVData* operator&() { return &m_value; }
-	operator CNVData*() { return &m_value; }
-	operator CNVData() { return m_value; }
-	ScopedCNVData& operator=(const ScopedCNVData& d) { m_value = d.m_value; return *this; }
-	ScopedCNVData& operator=(const CNVData& d) { m_value = d; return *this; }
+	ScopedCNVData(ScopedCNVData&& d) : m_value(d.release()) { }
+	ScopedCNVData& operator=(ScopedCNVData&& d) { reset(d.release()); return *this; }
+	/// dispose of any value we hold and return where an NI function can store a new one, e.g. CNVRead(reader, 10, &value)
+	CNVData* operator&() { dispose(); return &m_value; }
+	operator CNVData() const { return m_value; }
+	CNVData get() const { return m_value; }
 	bool operator==(CNVData d) const { return m_value == d; }
 	bool operator!=(CNVData d) const { return m_value != d; }
+	/// give up ownership of the CNVData, it will no longer be disposed by us
+	CNVData release() { CNVData d = m_value; m_value = 0; return d; }
+	/// dispose of any value we hold and take ownership of \a d
+	void reset(CNVData d = 0) { dispose(); m_value = d; }
 	void dispose()
 	{
         int status = 0;
@@ -137,10 +144,190 @@ class ScopedCNVData
     ~ScopedCNVData() { dispose(); }
 };
 
+/// Estimate of the offset between the clock of a LabVIEW host and ours, from the difference between when a subscriber 
+/// update was received and its server timestamp. Network and processing delays only ever add to this difference, so 
+/// the smallest value seen is the best estimate; the estimate is allowed to slowly rise again so clock drift is followed.
+/// There is one instance per host, shared by all the parameters with correct_clock set, see forHost()
+class HostClock
+{
+public:
+	/// record an update with server timestamp \a server_ts that we received at \a local_ts 
+	void update(const epicsTimeStamp& server_ts, const epicsTimeStamp& local_ts)
+	{
+		double diff = epicsTimeDiffInSeconds(&local_ts, &server_ts);
+		epicsGuard<epicsMutex> _lock(m_lock);
+		if (m_nupdates == 0 || diff < m_offset)
+		{
+			m_offset = diff;
+		}
+		else
+		{
+			m_offset += 0.001 * (diff - m_offset);
+		}
+		m_last_diff = diff;
+		++m_nupdates;
+	}
+	/// adjust the server timestamp \a ts to our clock
+	void correct(epicsTimeStamp& ts)
+	{
+		double offset;
+		{
+			epicsGuard<epicsMutex> _lock(m_lock);
+			offset = m_offset;
+		}
+		epicsTimeAddSeconds(&ts, offset);
+	}
+	/// helper for asyn driver report function
+	void report(FILE* fp)
+	{
+		epicsGuard<epicsMutex> _lock(m_lock);
+		fprintf(fp, "  Clock offset of host \"%s\": %f s (latest update %f s, %lu updates)\n", m_host.c_str(), m_offset, m_last_diff, m_nupdates);
+	}
+	/// the instance for the host of the network shared variable \a nv_name e.g. \\\\host\\process\\variable
+	static HostClock* forHost(const std::string& nv_name)
+	{
+		static std::map<std::string, HostClock*> clocks;
+		static epicsMutex clocks_lock;
+		size_t start = nv_name.find_first_not_of('\\');
+		std::string host = (start != std::string::npos ? nv_name.substr(start, nv_name.find('\\', start) - start) : "");
+		std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+		epicsGuard<epicsMutex> _lock(clocks_lock);
+		HostClock*& clock = clocks[host];
+		if (clock == NULL)
+		{
+			clock = new HostClock(host);
+		}
+		return clock;
+	}
+private:
+	std::string m_host;
+	double m_offset; ///< seconds to add to a server time to give our time
+	double m_last_diff; ///< difference for the most recent update
+	unsigned long m_nupdates;
+	epicsMutex m_lock;
+	explicit HostClock(const std::string& host) : m_host(host), m_offset(0.0), m_last_diff(0.0), m_nupdates(0) { }
+};
+
 /// details about a network shared variable we have connected to an asyn parameter
 struct NvItem
 {
-	enum { Read=0x1, Write=0x2, BufferedRead=0x4, BufferedWrite=0x8, SingleRead=0x10 } NvAccessMode;   ///< possible access modes to network shared variable
+	enum { Read=NvAccessRead, Write=NvAccessWrite, BufferedRead=NvAccessBufferedRead, BufferedWrite=NvAccessBufferedWrite, SingleRead=NvAccessSingleRead } NvAccessMode;   ///< possible access modes to network shared variable
+	enum ConnState { ConnNotConnected=0, ConnConnecting, ConnConnected, ConnDisconnected, ConnFailed }; ///< state of our connections to the network shared variable 
+	enum SubArrayKind { NotSubArray=0, SubElement, SubSlice, SubRow, SubColumn }; ///< what part of the original array a sub array parameter refers to
+	/// latency measurement, see NvParamConfig::latency
+	struct Latency
+	{
+		NvItem* net_item; ///< derived float64 parameter with latest server to receive latency (ms), NULL if latency not measured
+		NvItem* pub_item; ///< derived float64 parameter with latest receive to publish latency (ms), NULL if latency not measured
+		LatencyHistogram net; ///< server timestamp to subscriber update received latencies
+		LatencyHistogram pub; ///< subscriber update received to parameter callbacks done latencies
+		Latency() : net_item(NULL), pub_item(NULL) { }
+	};
+	/// connection to LabVIEW alarm fields, or for an alarm _Set parameter the alarm it is
+	struct AlarmLink
+	{
+		bool connected; ///< alarm fields have been connected
+		int fields; ///< combination of #NvAlarmField to connect to, or -1 to look for them by browsing
+		NvItem* parent; ///< for a LabVIEW alarm _Set parameter, the parameter whose alarm status it controls, otherwise NULL
+		const char* type; ///< for a LabVIEW alarm _Set parameter, the alarm field name e.g. HiHi
+		epicsAlarmCondition stat; ///< for a LabVIEW alarm _Set parameter, EPICS alarm status to give #parent when set 
+		epicsAlarmSeverity sevr; ///< for a LabVIEW alarm _Set parameter, EPICS alarm severity to give #parent when set 
+		AlarmLink() : connected(false), fields(-1), parent(NULL), type(NULL), stat(epicsAlarmNone), sevr(epicsSevNone) { }
+	};
+	/// limit on the rate subscriber updates are processed at
+	struct RateLimit
+	{
+		double max_rate; ///< maximum rate (Hz) at which subscriber updates are processed, 0 means no limit
+		epicsTimeStamp last_processed; ///< when we last processed a subscriber update, used with #max_rate
+		ScopedCNVData pending; ///< latest subscriber update deferred due to #max_rate, processed later by NetShrVarInterface::updateValues()
+		unsigned long n_coalesced; ///< number of subscriber updates discarded due to #max_rate
+		epicsMutex lock; ///< protects #pending and #last_processed
+		explicit RateLimit(double max_rate_) : max_rate(max_rate_), n_coalesced(0) { memset(&last_processed, 0, sizeof(last_processed)); }
+	};
+	/// single read (SR) access
+	struct SingleReadState
+	{
+		double max_age; ///< a value read less than this many seconds ago is used rather than reading again
+		epicsTimeStamp last_read; ///< when we last did a single read
+		bool in_progress; ///< a single read is in progress (with the driver lock released)
+		epicsEvent done; ///< signalled when a single read finishes, for requests waiting on the read in progress
+		int status; ///< status returned by CNVRead() for the most recent single read
+		unsigned long n_reads; ///< number of single reads done
+		unsigned long n_cached; ///< number of single read requests satisfied from the cached value due to #max_age
+		unsigned long n_coalesced; ///< number of single read requests left to a read already in progress 
+		int poll_ms; ///< period (ms) at which we read the variable ourselves, 0 means only when a record asks
+		epicsTimeStamp next_poll; ///< when we next read the variable if #poll_ms is set, zero if not yet scheduled
+		SingleReadState() : max_age(0.0), in_progress(false), status(0), n_reads(0), n_cached(0), n_coalesced(0), poll_ms(0)
+		{
+			memset(&last_read, 0, sizeof(last_read));
+			memset(&next_poll, 0, sizeof(next_poll));
+		}
+	};
+	/// state of our connections to the network shared variable
+	struct Connection
+	{
+		ConnState state; ///< state of our connections
+		int attempts; ///< number of successive failed attempts to create our connections, sets the retry delay
+		epicsTimeStamp next_retry; ///< if #state is ConnFailed, when NetShrVarInterface::healthMonitor() next tries to connect
+		unsigned long n_failures; ///< number of failed attempts to create our connections
+		unsigned long n_retries; ///< number of retries by NetShrVarInterface::healthMonitor()
+		unsigned long n_disconnects; ///< number of times the NI library has reported a connection lost
+		epicsMutex lock; ///< held while creating or disposing our connections, so NetShrVarInterface::reloadConfig() and healthMonitor() cannot do both at once
+		Connection() : state(ConnNotConnected), attempts(0), n_failures(0), n_retries(0), n_disconnects(0) { memset(&next_retry, 0, sizeof(next_retry)); }
+	};
+	/// a value we have written, for write through
+	struct WrittenValue
+	{
+		double value; ///< numeric value written
+		epicsInt64 ivalue; ///< integer value written
+		std::string svalue; ///< string value written
+		WrittenValue() : value(0.0), ivalue(0) { }
+	};
+	/// write through, where a successful write updates the parameter with the write time and its subscriber echo is suppressed
+	struct WriteThrough
+	{
+		bool enabled; ///< write through was requested for this parameter
+		std::deque<WrittenValue> echoes_pending; ///< our writes whose subscriber update has not yet arrived, oldest first
+		epicsTimeStamp last_write; ///< when we last wrote the variable
+		WrittenValue value; ///< the value being written, added to #echoes_pending by NetShrVarInterface::writeThrough()
+		unsigned long n_suppressed; ///< number of subscriber updates suppressed as being the echo of our write
+		WriteThrough() : enabled(false), n_suppressed(0) { memset(&last_write, 0, sizeof(last_write)); }
+	};
+	/// derived array statistics and preview parameters
+	struct StatsParams
+	{
+		std::vector<NvItem*> items; ///< derived parameters for array statistics, indexed by ArrayStats enum, empty if not requested
+		NvItem* preview_item; ///< derived parameter for decimated array preview, NULL if not requested
+		size_t preview_size; ///< number of points in #preview_item
+		StatsParams() : preview_item(NULL), preview_size(0) { }
+	};
+	/// for a sub array parameter, the part of the original array it refers to
+	struct SubArray
+	{
+		std::vector<NvItem*> items; ///< derived parameters for single elements or slices of this array, see NetShrVarInterface::createSubArrayParam()
+		SubArrayKind kind; ///< what part of the original array a sub array parameter refers to
+		size_t start; ///< for a sub array parameter, index of first element (or row / column index)
+		size_t len; ///< for a sub array parameter, number of elements in slice
+		SubArray() : kind(NotSubArray), start(0), len(0) { }
+	};
+	/// shape of a multi dimensional array and its derived dimension parameters
+	struct ArrayShape
+	{
+		std::vector<size_t> dims; ///< dimensions of array from last update (after any transpose), slowest varying first
+		bool transpose; ///< transpose a two dimensional array before publishing it
+		NvItem* dims_item; ///< derived int32array parameter with array dimensions, NULL if not requested
+		NvItem* ndims_item; ///< derived int32 parameter with number of array dimensions, NULL if not requested
+		ArrayShape() : transpose(false), dims_item(NULL), ndims_item(NULL) { }
+	};
+	/// CNVData reused between array writes
+	struct WriteBuffer
+	{
+		ScopedCNVData data; ///< reused between writes while the array size and type stay the same 
+		CNVDataType type; ///< element type of #data
+		size_t elements; ///< number of elements in #data
+		bool busy; ///< #data is being written, so a concurrent write must use its own CNVData
+		WriteBuffer() : type(CNVEmpty), elements(0), busy(false) { }
+	};
 	std::string nv_name;   ///< full path to network shared variable 
 	std::string type;   ///< type as specified in the XML file e.g. float64array
 	unsigned access; ///< combination of #NvAccessMode
@@ -148,24 +335,79 @@ struct NvItem
 	int id; ///< asyn parameter id, -1 if not assigned
     std::string ts_param; ///< parameter that is timestamp source
     bool with_ts; ///< timestamp is encoded in first few array elements
-	bool connected_alarm;
+	NvTsSource ts_source; ///< where the timestamp of an update comes from, never #NvTsDefault
+	HostClock* host_clock; ///< if not NULL, used to correct server timestamps to our clock
+	bool restored; ///< value was restored from a snapshot file and no live data has arrived yet
+	bool derived; ///< value is computed by us from another parameter rather than read from a network shared variable
+	bool auto_created; ///< parameter was created by us (alarm field or sub array) rather than being listed in the XML file
+	bool removed; ///< parameter is no longer in the XML file (see NetShrVarInterface::reloadConfig()), so is disconnected and cannot be read or written
+	CallbackData* cb_data; ///< passed to the NI callbacks of our connections, created with the asyn parameter by NetShrVarInterface::initAsynParamIds()
+	Latency latency;
+	AlarmLink alarm;
+	RateLimit rate;
+	SingleReadState sr;
+	Connection conn;
+	WriteThrough write_through;
+	StatsParams stats;
+	SubArray sub;
+	ArrayShape shape;
 	std::vector<char> array_data; ///< only used for array parameters, contains cached copy of data as this is not stored in usual asyn parameter map
+	std::string string_value; ///< only used for string parameters, copy of current value that NetShrVarDriver::readOctet() can copy from directly; keeps its capacity between updates
+	WriteBuffer write_buf; ///< only used for array parameters
 	CNVSubscriber subscriber;
 	CNVBufferedSubscriber b_subscriber;
 	CNVWriter writer;
 	CNVReader reader;
 	CNVBufferedWriter b_writer;
 	epicsTimeStamp epicsTS; ///< timestamp of shared variable update
-	NvItem(const std::string& nv_name_, const char* type_, unsigned access_, int field_, const std::string& ts_param_, bool with_ts_) : nv_name(nv_name_), type(type_), access(access_),
-		field(field_), ts_param(ts_param_), with_ts(with_ts_), id(-1), subscriber(0), b_subscriber(0), writer(0), b_writer(0), reader(0), connected_alarm(false) 
+	NvItem(const std::string& nv_name_, const char* type_, unsigned access_, int field_, const std::string& ts_param_, bool with_ts_, double max_rate_ = 0.0) : nv_name(nv_name_), type(type_), access(access_),
+		field(field_), id(-1), ts_param(ts_param_), with_ts(with_ts_), ts_source(NvTsServer), host_clock(NULL), restored(false), derived(false), auto_created(false), removed(false), 
+		cb_data(NULL), rate(max_rate_), subscriber(0), b_subscriber(0), writer(0), reader(0), b_writer(0)
 	{ 
 	    memset(&epicsTS, 0, sizeof(epicsTS));
 	    std::replace(nv_name.begin(), nv_name.end(), '/', '\\'); // we accept / as well as \ in the XML file for path to variable
 	}
+	static const char* tsSourceName(NvTsSource source)
+	{
+		switch(source)
+		{
+			case NvTsServer:
+				return "server timestamp";
+			case NvTsLocalReceive:
+				return "time received";
+			case NvTsLinked:
+				return "linked timestamp";
+			case NvTsEmbedded:
+				return "embedded timestamp";
+			case NvTsNone:
+				return "timestamp not updated";
+			default:
+				return "unknown";
+		}
+	}
+	static const char* connStateName(ConnState state)
+	{
+		switch(state)
+		{
+			case ConnNotConnected:
+				return "not connected";
+			case ConnConnecting:
+				return "connecting";
+			case ConnConnected:
+				return "connected";
+			case ConnDisconnected:
+				return "disconnected";
+			case ConnFailed:
+				return "failed, will retry";
+			default:
+				return "unknown";
+		}
+	}
 	/// helper for asyn driver report function
 	void report(const std::string& name, FILE* fp)
 	{
-	    fprintf(fp, "Report for asyn parameter \"%s\" type \"%s\" network variable \"%s\"\n", name.c_str(), type.c_str(), nv_name.c_str());
+	    fprintf(fp, "Report for asyn parameter \"%s\" type \"%s\" network variable \"%s\"%s%s\n", name.c_str(), type.c_str(), nv_name.c_str(),
+		    (derived ? " (derived)" : ""), (removed ? " (removed)" : ""));
 		if (array_data.size() > 0)
 		{
 			fprintf(fp, "  Current array size (bytes): %d\n", (int)array_data.size());
@@ -179,7 +421,34 @@ struct NvItem
 		{
 			strcpy(tbuffer, "<unknown>");
 		}
-		fprintf(fp, "  Update time: %s\n", tbuffer);
+		fprintf(fp, "  Update time: %s (%s)\n", tbuffer, tsSourceName(ts_source));
+		if (host_clock != NULL)
+		{
+			host_clock->report(fp);
+		}
+		latency.net.report(fp, "Server to receive");
+		latency.pub.report(fp, "Receive to publish");
+		if (rate.max_rate > 0.0)
+		{
+			fprintf(fp, "  Maximum update rate: %f Hz (%lu updates coalesced)\n", rate.max_rate, rate.n_coalesced);
+		}
+		if (!derived)
+		{
+			fprintf(fp, "  Connection state: %s (%lu failed connection attempts, %lu retries, %lu times connection lost)\n", connStateName(conn.state), 
+			    conn.n_failures, conn.n_retries, conn.n_disconnects);
+		}
+		if (write_through.enabled)
+		{
+			fprintf(fp, "  Write through: %lu subscriber updates suppressed as echoes of our writes\n", write_through.n_suppressed);
+		}
+		if (access & SingleRead)
+		{
+			fprintf(fp, "  Single reads: %lu (%lu requests used cached value, %lu joined a read in progress)\n", sr.n_reads, sr.n_cached, sr.n_coalesced);
+			if (sr.poll_ms > 0)
+			{
+				fprintf(fp, "  Single read poll period: %d ms\n", sr.poll_ms);
+			}
+		}
 	    report(fp, "subscriber", subscriber, false);
 	    report(fp, "buffered subscriber", b_subscriber, true);
 	    report(fp, "writer", writer, false);
@@ -230,7 +499,9 @@ struct CallbackData
 	NetShrVarInterface* intf;
     std::string nv_name;
     int param_index;
-	CallbackData(NetShrVarInterface* intf_, const std::string& nv_name_, int param_index_) : intf(intf_), nv_name(nv_name_), param_index(param_index_) { } 
+	NvItem* item;
+	NvDispatcher::Slot dispatch_slot; ///< the update waiting for an #NvDispatcher worker thread, if any
+	CallbackData(NetShrVarInterface* intf_, const std::string& nv_name_, int param_index_, NvItem* item_) : intf(intf_), nv_name(nv_name_), param_index(param_index_), item(item_) { } 
 };
 
 static void CVICALLBACK DataCallback (void * handle, CNVData data, void * callbackData);
@@ -338,6 +609,160 @@ bool NetShrVarInterface::pathExists(const std::string& path)
 #endif
 }
 
+/// Cache of network shared variable browse results, held as a trie of path components. To see if a path exists 
+/// its parent is browsed once and all of the parent's children recorded, so checking the other variables 
+/// in the same process or folder does not need another browse. LabVIEW names are not case sensitive, so 
+/// components are stored in lower case.
+class BrowseCache
+{
+public:
+	BrowseCache() : m_root(NULL), m_nbrowse(0) { }
+	bool pathExists(const std::string& path);
+	void clear();
+	int numberOfBrowses() const { return m_nbrowse; }
+private:
+	struct Node
+	{
+		bool browsed;
+		std::map<std::string, Node*> children;
+		Node() : browsed(false) { }
+		~Node()
+		{
+			for(std::map<std::string, Node*>::iterator it = children.begin(); it != children.end(); ++it)
+			{
+				delete it->second;
+			}
+		}
+	};
+	Node* m_root;
+	int m_nbrowse; ///< number of browse operations we have done
+	epicsMutex m_lock;
+	void browse(const std::string& path, Node* node);
+	static std::string lowerCase(const std::string& str)
+	{
+		std::string res(str);
+		std::transform(res.begin(), res.end(), res.begin(), ::tolower);
+		return res;
+	}
+};
+
+static BrowseCache browse_cache; ///< shared by all NetShrVarInterface instances
+
+/// forget all browse results, so later calls to pathExists() browse again
+void BrowseCache::clear()
+{
+	epicsGuard<epicsMutex> _lock(m_lock);
+	delete m_root;
+	m_root = NULL;
+}
+
+/// record the children of \a path in \a node. The node is only marked as browsed if the browse succeeds, so a path
+/// that does not exist (which CNVBrowse() cannot tell apart from a failure to browse) is browsed again next time it is
+/// checked rather than remembered as having no children
+void BrowseCache::browse(const std::string& path, Node* node)
+{
+	++m_nbrowse;
+#ifdef _WIN32
+	CNVBrowser browser = NULL;
+	char* item = NULL;
+	int leaf, error;
+	CNVBrowseType browseType = CNVBrowseTypeUndefined;
+	std::vector<std::string> names;
+	error = CNVCreateBrowser(&browser);
+	ERROR_CHECK("CNVCreateBrowser", error);
+	error = CNVBrowse(browser, path.c_str()); // error < 0 = not found
+	if (error < 0)
+	{
+		CNVDisposeBrowser(browser);
+		return;
+	}
+	while(true)
+	{
+	    error = CNVBrowseNextItem(browser, &item, &leaf, &browseType, NULL);
+		if (error < 0)
+		{
+			CNVDisposeBrowser(browser);
+			ERROR_CHECK("CNVBrowseNextItem", error);
+		}
+		if (error == 0 || item == NULL)
+		{
+			break;
+		}
+		std::string name(item);
+		CNVFreeMemory(item);
+		item = NULL;
+		size_t pos = name.rfind('\\');
+		names.push_back(lowerCase(pos != std::string::npos ? name.substr(pos + 1) : name));
+	}
+	CNVDisposeBrowser(browser);
+	for(size_t i=0; i<names.size(); ++i)
+	{
+		if (node->children.find(names[i]) == node->children.end())
+		{
+			node->children[names[i]] = new Node;
+		}
+	}
+	node->browsed = true;
+#endif
+}
+
+/// does a network shared variable path exist, using cached browse results where possible
+bool BrowseCache::pathExists(const std::string& path)
+{
+    static int netshrvar_simulate = getenv("NETSHRVAR_SIMULATE") != NULL ? atoi(getenv("NETSHRVAR_SIMULATE")) : 0;
+    if (netshrvar_simulate)
+    {
+        return true;
+    }
+#ifdef _WIN32
+	std::vector<std::string> components;
+	size_t start = 0, end;
+	do
+	{
+		end = path.find('\\', start);
+		std::string comp = path.substr(start, (end == std::string::npos ? end : end - start));
+		if (comp.size() > 0)
+		{
+			components.push_back(comp);
+		}
+		start = end + 1;
+	} while(end != std::string::npos);
+	if (components.size() < 2)
+	{
+		return NetShrVarInterface::pathExists(path);
+	}
+	epicsGuard<epicsMutex> _lock(m_lock);
+	if (m_root == NULL)
+	{
+		m_root = new Node;
+	}
+	Node* parent = m_root;
+	std::string parent_path = "\\";
+	for(size_t i=0; i<components.size() - 1; ++i)
+	{
+		std::string name = lowerCase(components[i]);
+		std::map<std::string, Node*>::iterator it = parent->children.find(name);
+		if (it == parent->children.end())
+		{
+			if (parent->browsed)
+			{
+				return false;  // we have browsed this level before, and this component was not there
+			}
+			it = parent->children.insert(std::pair<std::string, Node*>(name, new Node)).first;
+		}
+		parent = it->second;
+		parent_path += "\\" + components[i];
+	}
+	if (!parent->browsed)
+	{
+		browse(parent_path, parent);
+	}
+	return parent->children.find(lowerCase(components.back())) != parent->children.end();
+#else
+	return true;
+#endif
+}
+
 // this only works for localhost variables
 bool NetShrVarInterface::varExists(const std::string& path)
 {
@@ -381,11 +806,8 @@ bool NetShrVarInterface::varExists(const std::string& path)
 
 void NetShrVarInterface::connectVars()
 {
-	int error;
-	CallbackData* cb_data;
-	int waitTime = 3000; // in milliseconds, or CNVWaitForever 
-	int clientBufferMaxItems = 200;
 #ifdef _WIN32
+	int error;
     int running = 0;
     error = CNVVariableEngineIsRunning(&running); 
 	ERROR_CHECK("CNVVariableEngineIsRunning", error);
@@ -410,133 +832,821 @@ void NetShrVarInterface::connectVars()
 #endif
 
     // look for alarm network variables
-	static const char* alarm_fields[] = { "Hi", "HiHi", "Lo", "LoLo" };
 	params_t new_params;
+	int nbrowse = browse_cache.numberOfBrowses();
 	for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
 	{
-		NvItem* item = it->second;
-		std::string param_name = it->first;
-		if (pathExists(item->nv_name))
-		{
-			for(int i=0; i<sizeof(alarm_fields) / sizeof(const char*); ++i)
-			{
-				std::string prefix = item->nv_name + "\\Alarms\\" + alarm_fields[i] + "\\";
-				if (pathExists(prefix + "Enable"))
-				{
-					std::cerr << "Adding " << alarm_fields[i] << " alarm field for " << item->nv_name << " (asyn parameter: " << param_name << ")" << std::endl;
-					item->connected_alarm = true;
-					new_params[param_name + "_" + alarm_fields[i] + "_Enable"] = new NvItem(prefix + "Enable", "boolean", NvItem::Read|NvItem::Write, -1, "", false);
-					new_params[param_name + "_" + alarm_fields[i] + "_Set"] = new NvItem(prefix + "Set", "boolean", NvItem::Read, -1, "", false);
-					new_params[param_name + "_" + alarm_fields[i] + "_Ack"] = new NvItem(prefix + "Ack", "boolean", NvItem::Read, -1, "", false);
-					new_params[param_name + "_" + alarm_fields[i] + "_AckType"] = new NvItem(prefix + "AckType", "int32", NvItem::Read|NvItem::Write, -1, "", false);
-					new_params[param_name + "_" + alarm_fields[i] + "_level"] = new NvItem(prefix + "level", "float64", NvItem::Read|NvItem::Write, -1, "", false);
-					new_params[param_name + "_" + alarm_fields[i] + "_deadband"] = new NvItem(prefix + "deadband", "float64", NvItem::Read|NvItem::Write, -1, "", false);
-				}
-			}
-		}
+		addAlarmParams(it->first, it->second, new_params);
 	}
+	m_driver->lock();
+	m_params_lock.lock();
 	m_params.insert(new_params.begin(), new_params.end());
+	m_params_lock.unlock();
+	m_driver->unlock();
+	std::cerr << "connectVars: alarm field discovery needed " << browse_cache.numberOfBrowses() - nbrowse << " browse operations" << std::endl;
 	
 	initAsynParamIds();
-    static int netshrvar_simulate = getenv("NETSHRVAR_SIMULATE") != NULL ? atoi(getenv("NETSHRVAR_SIMULATE")) : 0;
+	if (m_snapshot_file.size() > 0)
+	{
+		restoreSnapshot();
+	}
 
 	// now connect vars
 	for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
 	{
-		NvItem* item = it->second;
-	    cb_data = new CallbackData(this, item->nv_name, item->id);
-		
-		std::cerr << "connectVars: connecting to \"" << item->nv_name << "\"" << std::endl;
-		
-		// create either reader or buffered reader
-        if (netshrvar_simulate)
-        {
-            ;
-        }
-		else if (item->access & NvItem::Read)
-		{
-	        error = CNVCreateSubscriber(item->nv_name.c_str(), DataCallback, StatusCallback, cb_data, waitTime, 0, &(item->subscriber));
-	        ERROR_PRINT_CONTINUE("CNVCreateSubscriber", error);
-			readVarInit(item);
-		}
-		else if (item->access & NvItem::BufferedRead)
+		connectItem(it->second);
+	}
+	startSingleReadPolling();
+	startSnapshots();
+	startHealthMonitor();
+}
+
+/// start the thread that reads single read (SR) parameters with a poll_ms attribute, if any and not already started
+void NetShrVarInterface::startSingleReadPolling()
+{
+	if (m_sr_polling.started || m_shutting_down)
+	{
+		return;
+	}
+	bool needed = false;
+	std::vector<const params_t::value_type*> entries;
+	paramEntries(entries);
+	for(std::vector<const params_t::value_type*>::const_iterator it=entries.begin(); it != entries.end() && !needed; ++it)
+	{
+		needed = ((*it)->second->sr.poll_ms > 0);
+	}
+	if (!needed)
+	{
+		return;
+	}
+	std::string thread_name = "NSVSRPoll" + m_configSection;
+	if (epicsThreadCreate(thread_name.c_str(), epicsThreadPriorityMedium,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium), singleReadPollThread, this) == 0)
+	{
+		std::cerr << "startSingleReadPolling: epicsThreadCreate failure" << std::endl;
+		return;
+	}
+	m_sr_polling.started = true;
+}
+
+void NetShrVarInterface::singleReadPollThread(void* arg)
+{
+	NetShrVarInterface* netvarint = static_cast<NetShrVarInterface*>(arg);
+	netvarint->pollSingleReads();
+	netvarint->m_sr_polling.done.signal();
+}
+
+/// Read single read (SR) parameters that have a poll_ms attribute when they are due and publish the value, so 
+/// records can use SCAN="I/O Intr" rather than each scanning periodically. Parameters with the same period are
+/// given start times spread evenly over that period, so reads do not all happen at once.
+void NetShrVarInterface::pollSingleReads()
+{
+	std::vector< std::pair<std::string, NvItem*> > due;
+	while(!m_shutting_down)
+	{
+		epicsTimeStamp now;
+		double wait = 1.0; // so we notice parameters added by reloadConfig() and shutdown 
+		epicsTimeGetCurrent(&now);
+		due.clear();
+		m_driver->lock();
+		std::map< int, std::vector<NvItem*> > unscheduled; // by poll_ms
+		for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
 		{
-	        error = CNVCreateBufferedSubscriber(item->nv_name.c_str(), StatusCallback, cb_data, clientBufferMaxItems, waitTime, 0, &(item->b_subscriber));
-	        ERROR_PRINT_CONTINUE("CNVCreateBufferedSubscriber", error);
-			readVarInit(item);
+			NvItem* item = it->second;
+			if (item->sr.poll_ms <= 0 || !(item->access & NvItem::SingleRead) || item->removed)
+			{
+				continue;
+			}
+			if (item->sr.next_poll.secPastEpoch == 0)
+			{
+				unscheduled[item->sr.poll_ms].push_back(item);
+			}
+			else if (epicsTimeDiffInSeconds(&(item->sr.next_poll), &now) <= 0.0)
+			{
+				due.push_back(*it);
+				// schedule from the previous due time rather than now, so the spread is kept 
+				epicsTimeAddSeconds(&(item->sr.next_poll), item->sr.poll_ms / 1000.0);
+				if (epicsTimeDiffInSeconds(&(item->sr.next_poll), &now) <= 0.0)
+				{
+					item->sr.next_poll = now;  // we have fallen behind, do not try and catch up
+					epicsTimeAddSeconds(&(item->sr.next_poll), item->sr.poll_ms / 1000.0);
+				}
+			}
+			wait = std::min(wait, epicsTimeDiffInSeconds(&(item->sr.next_poll), &now));
 		}
-		else if (item->access & NvItem::SingleRead)
+		for(std::map< int, std::vector<NvItem*> >::const_iterator it = unscheduled.begin(); it != unscheduled.end(); ++it)
 		{
-	        error = CNVCreateReader(item->nv_name.c_str(), StatusCallback, cb_data, waitTime, 0, &(item->reader));
-	        ERROR_PRINT_CONTINUE("CNVCreateReader", error);
+			const std::vector<NvItem*>& items = it->second;
+			for(size_t i=0; i<items.size(); ++i)
+			{
+				double phase = (it->first / 1000.0) * static_cast<double>(i) / static_cast<double>(items.size());
+				items[i]->sr.next_poll = now;
+				epicsTimeAddSeconds(&(items[i]->sr.next_poll), phase);
+				wait = std::min(wait, phase);
+			}
 		}
-		// create either writer or buffered writer
-        if (netshrvar_simulate)
-        {
-            ;
-        }
-		else if (item->access & NvItem::Write)
+		for(size_t i=0; i<due.size(); ++i)
 		{
-	        error = CNVCreateWriter(item->nv_name.c_str(), StatusCallback, cb_data, waitTime, 0, &(item->writer));
-	        ERROR_PRINT_CONTINUE("CNVCreateWriter", error);
+			try
+			{
+				NvItem* item = due[i].second;
+				singleRead(due[i].first.c_str(), item, item->type.size() > 5 && item->type.substr(item->type.size() - 5) == "array");
+			}
+			catch(const std::exception& ex)
+			{
+				std::cerr << "pollSingleReads: " << due[i].first << ": " << ex.what() << std::endl;
+				setParamStatus(due[i].second->id, asynError);
+			}
 		}
-		else if (item->access & NvItem::BufferedWrite)
+		m_driver->unlock();
+		if (due.size() == 0 && wait > 0.0)
 		{
-	        error = CNVCreateBufferedWriter(item->nv_name.c_str(), DataTransferredCallback, StatusCallback, cb_data, clientBufferMaxItems, waitTime, 0, &(item->b_writer));
-	        ERROR_PRINT_CONTINUE("CNVCreateBufferedWriter", error);
+			m_sr_polling.wake.wait(wait);
 		}
 	}
 }
 
-/// the quality of the data in a network shared variable
-static std::string dataQuality(CNVDataQuality quality)
+/// Start the thread that does the initial reads deferred by connectItem() for parameters restored from a snapshot and
+/// then writes a snapshot every #m_snapshot_period seconds, if a snapshot file is in use and the thread is not already started
+void NetShrVarInterface::startSnapshots()
 {
-    std::string res;
-    char* description = NULL;
-    int error = CNVGetDataQualityDescription(quality, ";", &description); 
-    if (error == 0)
-    {
-        res = description;
-        CNVFreeMemory(description);
-    }
-    else
-    {
-        res = std::string("CNVGetDataQualityDescription: ") + CNVGetErrorDescription(error);
-    }
-    return res;
+	if (m_snapshot_file.size() == 0 || m_snapshot_thread.started || m_shutting_down)
+	{
+		return;
+	}
+	std::string thread_name = "NSVSnap" + m_configSection;
+	if (epicsThreadCreate(thread_name.c_str(), epicsThreadPriorityLow,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium), snapshotThread, this) == 0)
+	{
+		std::cerr << "startSnapshots: epicsThreadCreate failure" << std::endl;
+		return;
+	}
+	m_snapshot_thread.started = true;
 }
 
-/// called when data has been transferred to the variable
-static void CVICALLBACK DataTransferredCallback(void * handle, int error, void * callbackData)
+void NetShrVarInterface::snapshotThread(void* arg)
 {
-	CallbackData* cb_data = (CallbackData*)callbackData;
-	cb_data->intf->dataTransferredCallback(handle, error, cb_data);
+	NetShrVarInterface* netvarint = static_cast<NetShrVarInterface*>(arg);
+	netvarint->snapshotLoop();
+	netvarint->m_snapshot_thread.done.signal();
 }
 
-/// called when data has been transferred to the variable
-void NetShrVarInterface::dataTransferredCallback (void * handle, int error, CallbackData* cb_data)
+void NetShrVarInterface::snapshotLoop()
 {
-	if (error < 0)
+	std::vector<NvItem*> deferred;
+	m_driver->lock();
+	deferred.swap(m_deferred_init);
+	m_driver->unlock();
+	for(size_t i=0; i<deferred.size() && !m_shutting_down; ++i)
 	{
-		std::cerr << "dataTransferredCallback: \"" << cb_data->nv_name << "\": " << CNVGetErrorDescription(error) << std::endl;
-		setParamStatus(cb_data->param_index, asynError);
+		readVarInit(deferred[i]);
+	}
+	while(!m_shutting_down)
+	{
+		m_snapshot_thread.wake.wait(m_snapshot_period);
+		if (m_shutting_down)
+		{
+			break;  // epicsExitFunc() writes the final snapshot
+		}
+		try
+		{
+			writeSnapshot();
+		}
+		catch(const std::exception& ex)
+		{
+			std::cerr << "snapshotLoop: " << ex.what() << std::endl;
+		}
 	}
-//	else
-//	{
-//		std::cerr << "dataTransferredCallback: " << cb_data->nv_name << " OK " << std::endl;
-//	}
 }
 
-/// called when new data is available on a subscriber connection
-static void CVICALLBACK DataCallback (void * handle, CNVData data, void * callbackData)
+/// append \a n bytes from \a data to \a buffer
+static void putBytes(std::vector<char>& buffer, const void* data, size_t n)
 {
-	try
+	const char* p = static_cast<const char*>(data);
+	buffer.insert(buffer.end(), p, p + n);
+}
+
+/// append a string to \a buffer as a 32bit length followed by its characters
+static void putString(std::vector<char>& buffer, const char* data, size_t n)
+{
+	epicsUInt32 len = static_cast<epicsUInt32>(n);
+	putBytes(buffer, &len, sizeof(len));
+	putBytes(buffer, data, n);
+}
+
+/// read a string written by putString() from a stream of \a size bytes, fails rather than allocating for a 
+/// corrupt length that is more than the rest of the stream
+static bool getString(std::istream& is, std::streamoff size, std::string& str)
+{
+	epicsUInt32 len = 0;
+	if (!is.read(reinterpret_cast<char*>(&len), sizeof(len)))
 	{
-	    CallbackData* cb_data = (CallbackData*)callbackData;
-	    cb_data->intf->dataCallback(handle, data, cb_data);
-	    CNVDisposeData (data);
+		return false;
 	}
-	catch(const std::exception& ex)
+	std::streamoff pos = is.tellg();
+	if (pos < 0 || static_cast<std::streamoff>(len) > size - pos)
+	{
+		std::cerr << "getString: invalid length " << len << " at offset " << pos << std::endl;
+		return false;
+	}
+	str.resize(len);
+	return (len == 0 || is.read(&(str[0]), len));
+}
+
+static const char snapshot_magic[8] = { 'N', 'S', 'V', 'S', 'N', 'A', 'P', '1' };
+
+/// Write the current value, timestamp and alarm status of each parameter that has been updated to #m_snapshot_file.
+/// The file is binary (native byte order, as it is only read back on the same machine): a header, then for each 
+/// parameter its name, type, timestamp, alarm status and severity and value, strings and values being prefixed with 
+/// a 32bit length. The data is gathered with the driver locked, then written to a temporary file that is renamed over 
+/// the previous snapshot, so a crash while writing leaves the previous snapshot intact.
+void NetShrVarInterface::writeSnapshot()
+{
+	std::vector<char> buffer;
+	putBytes(buffer, snapshot_magic, sizeof(snapshot_magic));
+	m_driver->lock();
+	for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
+	{
+		const NvItem* item = it->second;
+		if (item->id == -1 || item->removed || item->epicsTS.secPastEpoch == 0 || !(item->access & (NvItem::Read | NvItem::BufferedRead | NvItem::SingleRead)))
+		{
+			continue;
+		}
+		epicsFloat64 dval = 0.0;
+		epicsInt32 ival = 0;
+		epicsInt64 i64val = 0;
+		const char* value = NULL;
+		size_t value_size = 0;
+		if (item->type == "float64" || item->type == "float32" || item->type == "ftimestamp")
+		{
+			m_driver->getDoubleParam(item->id, &dval);
+			value = reinterpret_cast<const char*>(&dval);
+			value_size = sizeof(dval);
+		}
+		else if (item->type == "int32" || item->type == "boolean")
+		{
+			m_driver->getIntegerParam(item->id, &ival);
+			value = reinterpret_cast<const char*>(&ival);
+			value_size = sizeof(ival);
+		}
+		else if (item->type == "int64" || item->type == "uint64")
+		{
+			m_driver->getInteger64Param(item->id, &i64val);
+			value = reinterpret_cast<const char*>(&i64val);
+			value_size = sizeof(i64val);
+		}
+		else if (item->type == "string" || item->type == "timestamp")
+		{
+			value = item->string_value.c_str();
+			value_size = item->string_value.size();
+		}
+		else if (item->array_data.size() > 0)
+		{
+			value = &(item->array_data[0]);
+			value_size = item->array_data.size();
+		}
+		else
+		{
+			continue;
+		}
+		int alarm_stat = 0, alarm_sevr = 0;
+		m_driver->getParamAlarmStatus(item->id, &alarm_stat);
+		m_driver->getParamAlarmSeverity(item->id, &alarm_sevr);
+		epicsUInt32 header[4] = { item->epicsTS.secPastEpoch, item->epicsTS.nsec, static_cast<epicsUInt32>(alarm_stat), static_cast<epicsUInt32>(alarm_sevr) };
+		putString(buffer, it->first.c_str(), it->first.size());
+		putString(buffer, item->type.c_str(), item->type.size());
+		putBytes(buffer, header, sizeof(header));
+		putString(buffer, value, value_size);
+	}
+	m_driver->unlock();
+	std::string tmp_file = m_snapshot_file + ".tmp";
+	{
+		std::ofstream ofs(tmp_file.c_str(), std::ios::binary | std::ios::trunc);
+		if (!ofs.write(&(buffer[0]), buffer.size()) || !ofs.flush())
+		{
+			throw std::runtime_error("writeSnapshot: cannot write \"" + tmp_file + "\"");
+		}
+	}
+#ifdef _WIN32
+	if (MoveFileEx(tmp_file.c_str(), m_snapshot_file.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == 0)
+#else
+	if (rename(tmp_file.c_str(), m_snapshot_file.c_str()) != 0)
+#endif
+	{
+		throw std::runtime_error("writeSnapshot: cannot rename \"" + tmp_file + "\" to \"" + m_snapshot_file + "\"");
+	}
+}
+
+/// size of an element of the asyn array for parameter type \a type, 0 if \a type is not an array type
+static size_t arrayElementSize(const std::string& type)
+{
+	if (type == "float64array" || type == "int64array" || type == "uint64array")
+	{
+		return 8;
+	}
+	else if (type == "float32array" || type == "int32array")
+	{
+		return 4;
+	}
+	else if (type == "int16array")
+	{
+		return 2;
+	}
+	else if (type == "int8array" || type == "longstring")
+	{
+		return 1;
+	}
+	return 0;
+}
+
+/// publish an array value restored from a snapshot as if it was an update, so I/O Intr records and any derived
+/// statistics, preview and sub array parameters see it. The snapshot does not record dimensions, so the array 
+/// is published as one dimensional. Called with m_driver locked 
+void NetShrVarInterface::publishRestoredArray(NvItem* item, const std::string& value)
+{
+	if (item->type == "float64array")
+	{
+		publishRestoredArrayImpl<epicsFloat64>(item, value);
+	}
+	else if (item->type == "float32array")
+	{
+		publishRestoredArrayImpl<epicsFloat32>(item, value);
+	}
+	else if (item->type == "int32array")
+	{
+		publishRestoredArrayImpl<epicsInt32>(item, value);
+	}
+	else if (item->type == "int16array")
+	{
+		publishRestoredArrayImpl<epicsInt16>(item, value);
+	}
+	else if (item->type == "int8array")
+	{
+		publishRestoredArrayImpl<epicsInt8>(item, value);
+	}
+	else if (item->type == "int64array" || item->type == "uint64array")
+	{
+		publishRestoredArrayImpl<__int64>(item, value);
+	}
+	else if (item->type == "longstring")
+	{
+		updateLongStringValue(item->id, item, value.c_str());  // saved with its terminating NULL
+	}
+}
+
+template<typename U>
+void NetShrVarInterface::publishRestoredArrayImpl(NvItem* item, const std::string& value)
+{
+	std::vector<U> data(value.size() / sizeof(U));  // a copy so the elements are aligned
+	memcpy(&(data[0]), value.data(), data.size() * sizeof(U));
+	std::vector<size_t> dims(1, data.size());
+	epicsTimeStamp epicsTS = item->epicsTS;
+	updateParamArrayValueImpl<U,U>(item->id, item, &(data[0]), data.size(), &epicsTS, dims);
+}
+
+/// Set parameters from the values in #m_snapshot_file written by a previous run, so they have a value before the
+/// shared variables are connected. A restored parameter has at least a MINOR UDF alarm until live data arrives, 
+/// see updateParamCNV(). As the asyn timestamp is per port, callbacks are done for each parameter in turn with the
+/// port timestamp set to its saved timestamp, so I/O Intr records get the saved timestamp. Entries whose parameter 
+/// no longer exists or has changed type are ignored, reading stops at the first corrupt entry.
+void NetShrVarInterface::restoreSnapshot()
+{
+	std::ifstream ifs(m_snapshot_file.c_str(), std::ios::binary);
+	std::streamoff size = 0;
+	if (ifs.seekg(0, std::ios::end))
+	{
+		size = ifs.tellg();
+		ifs.seekg(0, std::ios::beg);
+	}
+	char magic[sizeof(snapshot_magic)];
+	if (!ifs.read(magic, sizeof(magic)))
+	{
+		std::cerr << "restoreSnapshot: no snapshot file \"" << m_snapshot_file << "\"" << std::endl;
+		return;
+	}
+	if (memcmp(magic, snapshot_magic, sizeof(magic)) != 0)
+	{
+		std::cerr << "restoreSnapshot: \"" << m_snapshot_file << "\" is not a snapshot file" << std::endl;
+		return;
+	}
+	std::string name, type, value;
+	epicsUInt32 header[4];
+	int n_restored = 0;
+	epicsTimeStamp now;
+	epicsTimeGetCurrent(&now);
+	m_driver->lock();  // called from connectVars(), so we must not leave here with an exception and the driver locked 
+	try
+	{
+		while(getString(ifs, size, name) && getString(ifs, size, type) && ifs.read(reinterpret_cast<char*>(header), sizeof(header)) && getString(ifs, size, value))
+		{
+			params_t::const_iterator it = m_params.find(name);
+			if (it == m_params.end() || it->second->id == -1 || it->second->type != type || it->second->derived || it->second->removed ||
+			    !(it->second->access & (NvItem::Read | NvItem::BufferedRead | NvItem::SingleRead)))
+			{
+				continue;
+			}
+			NvItem* item = it->second;
+			if (type == "float64" || type == "float32" || type == "ftimestamp")
+			{
+				epicsFloat64 dval;
+				if (value.size() != sizeof(dval))
+				{
+					continue;
+				}
+				memcpy(&dval, value.data(), sizeof(dval));
+				m_driver->setDoubleParam(item->id, dval);
+			}
+			else if (type == "int32" || type == "boolean")
+			{
+				epicsInt32 ival;
+				if (value.size() != sizeof(ival))
+				{
+					continue;
+				}
+				memcpy(&ival, value.data(), sizeof(ival));
+				m_driver->setIntegerParam(item->id, ival);
+			}
+			else if (type == "int64" || type == "uint64")
+			{
+				epicsInt64 i64val;
+				if (value.size() != sizeof(i64val))
+				{
+					continue;
+				}
+				memcpy(&i64val, value.data(), sizeof(i64val));
+				m_driver->setInteger64Param(item->id, i64val);
+			}
+			else if (type == "string" || type == "timestamp")
+			{
+				item->string_value = value;
+				m_driver->setStringParam(item->id, item->string_value);
+			}
+			else
+			{
+				size_t element_size = arrayElementSize(type);
+				if (element_size == 0 || value.size() == 0 || value.size() % element_size != 0)
+				{
+					continue;
+				}
+			}
+			item->epicsTS.secPastEpoch = header[0];
+			item->epicsTS.nsec = header[1];
+			item->restored = true;
+			m_driver->setParamStatus(item->id, asynSuccess);
+			m_driver->setParamAlarmStatus(item->id, static_cast<int>(header[2]) != epicsAlarmNone ? static_cast<int>(header[2]) : epicsAlarmUDF);
+			m_driver->setParamAlarmSeverity(item->id, std::max(static_cast<int>(header[3]), static_cast<int>(epicsSevMinor)));
+			m_driver->setTimeStamp(&(item->epicsTS));
+			if (arrayElementSize(type) > 0)
+			{
+				publishRestoredArray(item, value);  // after the alarm status is set, as array callbacks pass it on
+			}
+			m_driver->callParamCallbacks();
+			++n_restored;
+		}
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "restoreSnapshot: error reading \"" << m_snapshot_file << "\": " << ex.what() << std::endl;
+	}
+	m_driver->setTimeStamp(&now);
+	m_driver->unlock();
+	std::cerr << "restoreSnapshot: restored " << n_restored << " parameters from \"" << m_snapshot_file << "\"" << std::endl;
+}
+
+/// look for the alarm network variables LabVIEW creates for a shared variable with alarming enabled, 
+/// and add parameters for them to \a new_params. This relies on LabVIEW publishing these as 
+///  <variable>\\Alarms\\<Hi|HiHi|Lo|LoLo>\\<Enable|Set|...>  so a variable with no  Alarms  child has no alarms.
+/// Which of the alarm folders exist is decided from the children of  Alarms , so discovery costs one browse of each 
+/// variable (to look for  Alarms , the browse of its process being shared) plus one of  Alarms  for a variable with 
+/// alarms. This can be avoided by listing the alarm fields in the XML file.
+void NetShrVarInterface::addAlarmParams(const std::string& param_name, NvItem* item, params_t& new_params)
+{
+	static const char* alarm_fields[] = { "Hi", "HiHi", "Lo", "LoLo" };
+	static const int alarm_bits[] = { NvAlarmHi, NvAlarmHiHi, NvAlarmLo, NvAlarmLoLo };
+	static const epicsAlarmCondition alarm_stats[] = { epicsAlarmHigh, epicsAlarmHiHi, epicsAlarmLow, epicsAlarmLoLo };
+	static const epicsAlarmSeverity alarm_sevrs[] = { epicsSevMinor, epicsSevMajor, epicsSevMinor, epicsSevMajor };
+	if (item->derived || item->alarm.fields == 0)
+	{
+		return;
+	}
+	// if alarm fields were specified in the XML file we can avoid browsing for them 
+	bool discover = (item->alarm.fields == -1);
+	if (discover && (!browse_cache.pathExists(item->nv_name) || !browse_cache.pathExists(item->nv_name + "\\Alarms")))
+	{
+		return;
+	}
+	for(size_t i=0; i<sizeof(alarm_fields) / sizeof(const char*); ++i)
+	{
+		std::string folder = item->nv_name + "\\Alarms\\" + alarm_fields[i];
+		std::string prefix = folder + "\\";
+		if ( discover ? browse_cache.pathExists(folder) : (item->alarm.fields & alarm_bits[i]) != 0 )
+		{
+			std::cerr << "Adding " << alarm_fields[i] << " alarm field for " << item->nv_name << " (asyn parameter: " << param_name << ")" << std::endl;
+			item->alarm.connected = true;
+			new_params[param_name + "_" + alarm_fields[i] + "_Enable"] = new NvItem(prefix + "Enable", "boolean", NvItem::Read|NvItem::Write, -1, "", false);
+			NvItem* set_item = new NvItem(prefix + "Set", "boolean", NvItem::Read, -1, "", false);
+			set_item->alarm.parent = item;  // so updateParamValue() can go straight to the parameter to alarm
+			set_item->alarm.type = alarm_fields[i];
+			set_item->alarm.stat = alarm_stats[i];
+			set_item->alarm.sevr = alarm_sevrs[i];
+			new_params[param_name + "_" + alarm_fields[i] + "_Set"] = set_item;
+			new_params[param_name + "_" + alarm_fields[i] + "_Ack"] = new NvItem(prefix + "Ack", "boolean", NvItem::Read, -1, "", false);
+			new_params[param_name + "_" + alarm_fields[i] + "_AckType"] = new NvItem(prefix + "AckType", "int32", NvItem::Read|NvItem::Write, -1, "", false);
+			new_params[param_name + "_" + alarm_fields[i] + "_level"] = new NvItem(prefix + "level", "float64", NvItem::Read|NvItem::Write, -1, "", false);
+			new_params[param_name + "_" + alarm_fields[i] + "_deadband"] = new NvItem(prefix + "deadband", "float64", NvItem::Read|NvItem::Write, -1, "", false);
+		}
+	}
+	for(params_t::iterator it = new_params.begin(); it != new_params.end(); ++it)
+	{
+		it->second->auto_created = true;
+	}
+}
+
+/// read the initial value of \a item now, or if it already has a value from a snapshot leave this to the snapshot thread
+/// so IOC startup does not wait for it
+void NetShrVarInterface::initialRead(NvItem* item)
+{
+	if (item->restored)
+	{
+		m_driver->lock();
+		m_deferred_init.push_back(item);
+		m_driver->unlock();
+	}
+	else
+	{
+		readVarInit(item);
+	}
+}
+
+/// create the subscriber, reader and writer connections for a parameter as specified by its access mode. Connections 
+/// that already exist are kept, so this can be called again by healthMonitor() to retry those that failed.
+/// \param[in] retry called by healthMonitor(), so only connect if the item is still waiting for a retry 
+/// \return true if all connections were made
+bool NetShrVarInterface::connectItem(NvItem* item, bool retry)
+{
+	int error;
+	CallbackData* cb_data;
+	int waitTime = 3000; // in milliseconds, or CNVWaitForever 
+	int clientBufferMaxItems = 200;
+    static int netshrvar_simulate = getenv("NETSHRVAR_SIMULATE") != NULL ? atoi(getenv("NETSHRVAR_SIMULATE")) : 0;
+	if (item->derived)
+	{
+		return true;
+	}
+	epicsGuard<epicsMutex> _conn_lock(item->conn.lock);
+	if (retry)
+	{
+		m_driver->lock();
+		bool failed = (item->conn.state == NvItem::ConnFailed);
+		m_driver->unlock();
+		if (!failed)
+		{
+			return false;  // reloadConfig() has disconnected it since the retry was scheduled
+		}
+	}
+	cb_data = item->cb_data;
+	
+	std::cerr << "connectVars: connecting to \"" << item->nv_name << "\"" << std::endl;
+	
+	// create either reader or buffered reader
+    if (netshrvar_simulate)
+    {
+        ;
+    }
+	else if (item->access & NvItem::Read)
+	{
+		if (item->subscriber == 0)
+		{
+            error = CNVCreateSubscriber(item->nv_name.c_str(), DataCallback, StatusCallback, cb_data, waitTime, 0, &(item->subscriber));
+			if (error < 0)
+			{
+				return connectFailed(item, "CNVCreateSubscriber", error);
+			}
+		    initialRead(item);
+		}
+	}
+	else if (item->access & NvItem::BufferedRead)
+	{
+		if (item->b_subscriber == 0)
+		{
+            error = CNVCreateBufferedSubscriber(item->nv_name.c_str(), StatusCallback, cb_data, clientBufferMaxItems, waitTime, 0, &(item->b_subscriber));
+			if (error < 0)
+			{
+				return connectFailed(item, "CNVCreateBufferedSubscriber", error);
+			}
+		    initialRead(item);
+		}
+	}
+	else if (item->access & NvItem::SingleRead)
+	{
+		if (item->reader == 0)
+		{
+            error = CNVCreateReader(item->nv_name.c_str(), StatusCallback, cb_data, waitTime, 0, &(item->reader));
+			if (error < 0)
+			{
+				return connectFailed(item, "CNVCreateReader", error);
+			}
+		}
+	}
+	// create either writer or buffered writer
+    if (netshrvar_simulate)
+    {
+        ;
+    }
+	else if (item->access & NvItem::Write)
+	{
+		if (item->writer == 0)
+		{
+            error = CNVCreateWriter(item->nv_name.c_str(), StatusCallback, cb_data, waitTime, 0, &(item->writer));
+			if (error < 0)
+			{
+				return connectFailed(item, "CNVCreateWriter", error);
+			}
+		}
+	}
+	else if (item->access & NvItem::BufferedWrite)
+	{
+		if (item->b_writer == 0)
+		{
+            error = CNVCreateBufferedWriter(item->nv_name.c_str(), DataTransferredCallback, StatusCallback, cb_data, clientBufferMaxItems, waitTime, 0, &(item->b_writer));
+			if (error < 0)
+			{
+				return connectFailed(item, "CNVCreateBufferedWriter", error);
+			}
+		}
+	}
+	m_driver->lock();
+	item->conn.state = NvItem::ConnConnected;
+	item->conn.attempts = 0;
+	m_driver->unlock();
+	return true;
+}
+
+/// a connection for \a item could not be created by \a func, schedule a retry by healthMonitor(). Successive failures 
+/// double the delay before the next retry, from #m_reconnect_min up to #m_reconnect_max seconds, and the delay is 
+/// randomised by up to a half so that the variables on a host that has gone away do not all retry together. 
+/// \return false
+bool NetShrVarInterface::connectFailed(NvItem* item, const char* func, int error)
+{
+	std::cerr << NetShrVarException::ni_message(func, error) << " for \"" << item->nv_name << "\"" << std::endl;
+	m_driver->lock();
+	double delay = std::min(m_reconnect_max, m_reconnect_min * pow(2.0, std::min(item->conn.attempts, 30)));
+	delay *= 0.5 + 0.5 * (rand() / (RAND_MAX + 1.0));
+	item->conn.state = NvItem::ConnFailed;
+	++(item->conn.attempts);
+	++(item->conn.n_failures);
+	epicsTimeGetCurrent(&(item->conn.next_retry));
+	epicsTimeAddSeconds(&(item->conn.next_retry), delay);
+	m_driver->unlock();
+	setParamStatus(item->id, asynDisconnected);
+	return false;
+}
+
+/// start the thread that retries failed connections, if not disabled and not already started
+void NetShrVarInterface::startHealthMonitor()
+{
+	if (m_health_monitor.started || m_shutting_down || m_reconnect_max <= 0.0)
+	{
+		return;
+	}
+	std::string thread_name = "NSVHealth" + m_configSection;
+	if (epicsThreadCreate(thread_name.c_str(), epicsThreadPriorityLow,
+	                      epicsThreadGetStackSize(epicsThreadStackMedium), healthMonitorThread, this) == 0)
+	{
+		std::cerr << "startHealthMonitor: epicsThreadCreate failure" << std::endl;
+		return;
+	}
+	m_health_monitor.started = true;
+}
+
+void NetShrVarInterface::healthMonitorThread(void* arg)
+{
+	NetShrVarInterface* netvarint = static_cast<NetShrVarInterface*>(arg);
+	netvarint->healthMonitor();
+	netvarint->m_health_monitor.done.signal();
+}
+
+/// Retry the connections of parameters that failed to connect once their retry time (see connectFailed()) has come.
+/// Connecting can block for a few seconds, so this is done on its own thread without the driver lock held, and data
+/// callbacks for other parameters carry on as normal. NvItem::Connection::lock stops this overlapping with reloadConfig()
+/// disconnecting the same item. A connection that is lost after being made is recovered by the NI library itself,
+/// this is just recorded by statusCallback().
+void NetShrVarInterface::healthMonitor()
+{
+	std::vector<NvItem*> due;
+	while(!m_shutting_down)
+	{
+		m_health_monitor.wake.wait(1.0);
+		if (m_shutting_down)
+		{
+			break;
+		}
+		epicsTimeStamp now;
+		epicsTimeGetCurrent(&now);
+		due.clear();
+		m_driver->lock();
+		for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
+		{
+			NvItem* item = it->second;
+			if (item->conn.state == NvItem::ConnFailed && !item->removed && epicsTimeDiffInSeconds(&now, &(item->conn.next_retry)) >= 0.0)
+			{
+				due.push_back(item);
+				++(item->conn.n_retries);
+			}
+		}
+		m_driver->unlock();
+		for(size_t i=0; i<due.size() && !m_shutting_down; ++i)
+		{
+			std::cerr << "healthMonitor: retrying connection to \"" << due[i]->nv_name << "\" (attempt " << due[i]->conn.attempts + 1 << ")" << std::endl;
+			if (connectItem(due[i], true))
+			{
+				std::cerr << "healthMonitor: connected to \"" << due[i]->nv_name << "\"" << std::endl;
+			    setParamStatus(due[i]->id, asynSuccess);
+			}
+		}
+	}
+}
+
+/// dispose of a network shared variable connection handle and zero it
+template<typename H>
+static void disposeHandle(H& handle)
+{
+	if (handle != 0)
+	{
+		int error = CNVDispose(handle);
+		if (error < 0)
+		{
+			std::cerr << NetShrVarException::ni_message("CNVDispose", error);
+		}
+		handle = 0;
+	}
+}
+
+/// dispose of any network shared variable connections for a parameter 
+void NetShrVarInterface::disconnectItem(NvItem* item)
+{
+	epicsGuard<epicsMutex> _conn_lock(item->conn.lock);
+	m_driver->lock();
+	item->conn.state = NvItem::ConnNotConnected;  // so healthMonitor() does not retry it
+	item->conn.attempts = 0;
+	m_driver->unlock();
+	disposeHandle(item->subscriber);
+	disposeHandle(item->b_subscriber);
+	disposeHandle(item->reader);
+	disposeHandle(item->writer);
+	disposeHandle(item->b_writer);
+	epicsGuard<epicsMutex> _pending_lock(item->rate.lock);
+	item->rate.pending.reset();  // any update deferred due to max_rate is no longer wanted
+}
+
+/// the quality of the data in a network shared variable
+static std::string dataQuality(CNVDataQuality quality)
+{
+    std::string res;
+    char* description = NULL;
+    int error = CNVGetDataQualityDescription(quality, ";", &description); 
+    if (error == 0)
+    {
+        res = description;
+        CNVFreeMemory(description);
+    }
+    else
+    {
+        res = std::string("CNVGetDataQualityDescription: ") + CNVGetErrorDescription(error);
+    }
+    return res;
+}
+
+/// called when data has been transferred to the variable
+static void CVICALLBACK DataTransferredCallback(void * handle, int error, void * callbackData)
+{
+	CallbackData* cb_data = (CallbackData*)callbackData;
+	cb_data->intf->dataTransferredCallback(handle, error, cb_data);
+}
+
+/// called when data has been transferred to the variable
+void NetShrVarInterface::dataTransferredCallback (void * handle, int error, CallbackData* cb_data)
+{
+	if (error < 0)
+	{
+		std::cerr << "dataTransferredCallback: \"" << cb_data->nv_name << "\": " << CNVGetErrorDescription(error) << std::endl;
+		setParamStatus(cb_data->param_index, asynError);
+	}
+//	else
+//	{
+//		std::cerr << "dataTransferredCallback: " << cb_data->nv_name << " OK " << std::endl;
+//	}
+}
+
+/// called when new data is available on a subscriber connection
+static void CVICALLBACK DataCallback (void * handle, CNVData data, void * callbackData)
+{
+	try
+	{
+	    CallbackData* cb_data = (CallbackData*)callbackData;
+	    cb_data->intf->dataCallback(handle, data, cb_data); // this takes ownership of data
+	}
+	catch(const std::exception& ex)
 	{
 		std::cerr << "DataCallback: ERROR : " << ex.what() << std::endl; 
 	}
@@ -546,13 +1656,58 @@ static void CVICALLBACK DataCallback (void * handle, CNVData data, void * callba
 	}	
 }
 
-/// called by DataCallback() when new data is available on a subscriber connection
+/// called on an #NvDispatcher worker thread to process an update queued by NetShrVarInterface::dataCallback()
+static void DispatchedDataCallback (void * callbackData, CNVData data, epicsUInt64 t_receive)
+{
+	try
+	{
+	    CallbackData* cb_data = (CallbackData*)callbackData;
+	    cb_data->intf->processDataCallback(data, cb_data, t_receive); // this takes ownership of data
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "DispatchedDataCallback: ERROR : " << ex.what() << std::endl; 
+	}
+	catch(...)
+	{
+		std::cerr << "DispatchedDataCallback: ERROR" << std::endl; 
+	}	
+}
+
+/// called by DataCallback() when new data is available on a subscriber connection.
+/// We take ownership of \a data, if we have an #NvDispatcher it is passed to a worker thread
+/// otherwise it is processed now
 void NetShrVarInterface::dataCallback (void * handle, CNVData data, CallbackData* cb_data)
+{
+	epicsUInt64 t_receive = epicsMonotonicGet();
+	if (m_dispatcher != NULL)
+	{
+		// shard on parameter index so updates to a variable keep their order
+		m_dispatcher->dispatch(cb_data->param_index, cb_data->dispatch_slot, cb_data, data, t_receive);
+	}
+	else
+	{
+		processDataCallback(data, cb_data, t_receive);
+	}
+}
+
+/// process new subscriber \a data received at \a t_receive (from epicsMonotonicGet()), we take ownership 
+/// of \a data and dispose of it when done, unless it is kept as a deferred update
+void NetShrVarInterface::processDataCallback (CNVData data, CallbackData* cb_data, epicsUInt64 t_receive)
 {
 //    std::cerr << "dataCallback: index " << cb_data->param_index << std::endl; 
+    ScopedCNVData sdata(data);
     try
 	{
+		if (cb_data->item->rate.max_rate > 0.0 && deferUpdate(cb_data->item, sdata))
+		{
+			return;
+		}
         updateParamCNV(cb_data->param_index, data, NULL, true);
+		if (cb_data->item->latency.net_item != NULL)
+		{
+			updateLatency(cb_data->item, data, t_receive);
+		}
 	}
 	catch(const std::exception& ex)
 	{
@@ -564,62 +1719,195 @@ void NetShrVarInterface::dataCallback (void * handle, CNVData data, CallbackData
 	}
 }
 
-void NetShrVarInterface::updateConnectedAlarmStatus(const std::string& paramName, int value, const std::string& alarmStr, epicsAlarmCondition stat, epicsAlarmSeverity sevr)
+/// Record the latencies of subscriber update \a data for \a item, which was received at \a t_receive (from epicsMonotonicGet())
+/// and has now been published. The wall clock time it was received is worked back from the monotonic clock, so that 
+/// the server to receive latency can be computed here rather than on the NI callback thread. This is only done for 
+/// parameters with latency="true" as it means decoding the server timestamp again.
+void NetShrVarInterface::updateLatency(NvItem* item, CNVData data, epicsUInt64 t_receive)
+{
+	epicsUInt64 t_publish = epicsMonotonicGet();
+	epicsTimeStamp now, received, server_ts;
+	epicsTimeGetCurrent(&now);
+	double pub_latency = (t_publish - t_receive) * 1e-9;
+	received = now;
+	epicsTimeAddSeconds(&received, -pub_latency);
+	item->latency.pub.add(pub_latency);
+	unsigned __int64 timestamp;
+	int status = CNVGetDataUTCTimestamp(data, &timestamp);
+	ERROR_CHECK("CNVGetDataUTCTimestamp", status);
+	if (convertTimeStamp(timestamp, &server_ts))
+	{
+		item->latency.net.add(epicsTimeDiffInSeconds(&received, &server_ts));
+	}
+	m_driver->lock();
+	item->latency.net_item->epicsTS = item->latency.pub_item->epicsTS = item->epicsTS;
+	m_driver->setDoubleParam(item->latency.net_item->id, item->latency.net.last() * 1e3);
+	m_driver->setDoubleParam(item->latency.pub_item->id, pub_latency * 1e3);
+	m_driver->callParamCallbacks();
+	m_driver->unlock();
+}
+
+/// Limit the rate subscriber updates are processed for an item with #NvItem::RateLimit::max_rate set.
+/// If an update arrives too soon after the last one we processed it replaces any pending update 
+/// (so the latest value wins) and returns true, the pending update is then processed later from updateValues(). 
+/// The timestamp is taken from the pending CNVData when it is processed, so is preserved.
+bool NetShrVarInterface::deferUpdate(NvItem* item, ScopedCNVData& data)
+{
+	epicsTimeStamp now;
+	epicsTimeGetCurrent(&now);
+	epicsGuard<epicsMutex> _lock(item->rate.lock);
+	if (item->rate.pending != 0)
+	{
+		++(item->rate.n_coalesced);
+	}
+	item->rate.pending.reset(); // this update supersedes any pending one
+	if (epicsTimeDiffInSeconds(&now, &(item->rate.last_processed)) >= 1.0 / item->rate.max_rate)
+	{
+		item->rate.last_processed = now;
+		return false;
+	}
+	item->rate.pending = std::move(data);
+	return true;
+}
+
+/// process an update deferred by deferUpdate() if enough time has now passed
+void NetShrVarInterface::processDeferredUpdate(NvItem* item)
+{
+	epicsTimeStamp now;
+	ScopedCNVData data;
+	epicsTimeGetCurrent(&now);
+	{
+		epicsGuard<epicsMutex> _lock(item->rate.lock);
+		if (item->rate.pending == 0 || epicsTimeDiffInSeconds(&now, &(item->rate.last_processed)) < 1.0 / item->rate.max_rate)
+		{
+			return;
+		}
+		item->rate.last_processed = now;
+		data = std::move(item->rate.pending);
+	}
+	updateParamCNV(item->id, data, NULL, true);
+}
+
+/// a LabVIEW alarm _Set parameter \a alarm_item has changed to \a value, update the alarm status of the parameter it refers to
+void NetShrVarInterface::updateConnectedAlarmStatus(const NvItem* alarm_item, int value)
 {
 	asynStatus status;
-	int connected_param_index = -1;
-	const char *conectedParamName = NULL;
-	std::string suffix = "_" + alarmStr + "_Set";
-	if ( (paramName.size() > suffix.size()) && (paramName.substr(paramName.size() - suffix.size()) == suffix) )
+	const char *connectedParamName = NULL;
+	int connected_param_index = alarm_item->alarm.parent->id;
+	// check if param is in error, if so don't update alarm sttaus
+	if ( (m_driver->getParamStatus(connected_param_index, &status) == asynSuccess) && (status == asynSuccess) )
 	{
-		std::string connectedParamName = paramName.substr(0, paramName.size() - suffix.size());
-	    if (m_driver->findParam(connectedParamName.c_str(), &connected_param_index) == asynSuccess)
+		m_driver->getParamName(connected_param_index, &connectedParamName);
+		std::cerr << "Alarm type " << alarm_item->alarm.type << (value != 0 ? " raised" : " cleared") << " for asyn parameter " << 
+		    (connectedParamName != NULL ? connectedParamName : "") << std::endl;
+		if (value != 0)
 		{
-			// check if param is in error, if so don't update alarm sttaus
-			if ( (m_driver->getParamStatus(connected_param_index, &status) == asynSuccess) && (status == asynSuccess) )
-			{
-				std::cerr << "Alarm type " << alarmStr << (value != 0 ? " raised" : " cleared") << " for asyn parameter " << connectedParamName << std::endl;
-				if (value != 0)
-				{
-			        setParamStatus(connected_param_index, asynSuccess, stat, sevr);
-				}
-				else
-				{
-			        setParamStatus(connected_param_index, asynSuccess);
-				}
-			}
+			setParamStatus(connected_param_index, asynSuccess, alarm_item->alarm.stat, alarm_item->alarm.sevr);
+		}
+		else
+		{
+			setParamStatus(connected_param_index, asynSuccess);
 		}
 	}
 }	
 
+/// For a #NvItem::WriteThrough parameter with writes pending, decide whether the subscriber update \a val is the echo of
+/// the oldest of them and so can be ignored: the parameter already shows the last value we wrote, so an echo of that or
+/// an earlier write has nothing new. An update with a different value (someone else wrote, or the NI library merged 
+/// updates) is published, as are any later updates as we can no longer tell which write they echo. Called with m_driver locked.
+template<typename T>
+bool NetShrVarInterface::isWriteEcho(NvItem* item, T val)
+{
+	static const double echo_timeout = 5.0;  // an update this long after our write is not an echo of it
+	epicsTimeStamp now;
+	epicsTimeGetCurrent(&now);
+	if (epicsTimeDiffInSeconds(&now, &(item->write_through.last_write)) > echo_timeout)
+	{
+		item->write_through.echoes_pending.clear();
+		return false;
+	}
+	const NvItem::WrittenValue& written = item->write_through.echoes_pending.front();
+	bool echo = false;
+	if (item->type == "float64" || item->type == "float32")
+	{
+		echo = (convertToScalar<double>(val) == written.value);
+	}
+	else if (item->type == "int32" || item->type == "boolean")
+	{
+		echo = (convertToScalar<int>(val) == static_cast<int>(written.ivalue));
+	}
+	else if (item->type == "int64" || item->type == "uint64")
+	{
+		echo = (convertToScalar<epicsInt64>(val) == written.ivalue);
+	}
+	else if (item->type == "string")
+	{
+		const char* sval = convertToPtr<char>(val);
+		echo = (written.svalue == (sval != NULL ? sval : ""));
+	}
+	if (echo)
+	{
+		item->write_through.echoes_pending.pop_front();
+	}
+	else
+	{
+		item->write_through.echoes_pending.clear();
+	}
+	return echo;
+}
+
 template<typename T>
 void NetShrVarInterface::updateParamValue(int param_index, T val, epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks)
 {
 	const char *paramName = NULL;
 	m_driver->lock();
 	m_driver->getParamName(param_index, &paramName);
+	params_t::const_iterator it = m_params.find(paramName);  // m_params is only changed with the driver locked
+	if (it == m_params.end())
+	{
+		m_driver->unlock();
+		throw std::runtime_error(std::string("updateParamValue: unknown parameter ") + paramName);
+	}
+	NvItem* item = it->second;
+	if (!item->write_through.echoes_pending.empty() && isWriteEcho(item, val))
+	{
+		++(item->write_through.n_suppressed);
+		m_driver->unlock();
+		return;
+	}
 	m_driver->setTimeStamp(epicsTS);
-    m_params[paramName]->epicsTS = *epicsTS;
-	if (m_params[paramName]->type == "float64" ||  m_params[paramName]->type == "ftimestamp")
+    item->epicsTS = *epicsTS;
+	if (item->type == "float64" || item->type == "float32" || item->type == "ftimestamp")
 	{
 	    m_driver->setDoubleParam(param_index, convertToScalar<double>(val));
 	}
-	else if (m_params[paramName]->type == "int32" || m_params[paramName]->type == "boolean")
+	else if (item->type == "int32" || item->type == "boolean")
 	{
 		int intVal = convertToScalar<int>(val);
 	    m_driver->setIntegerParam(param_index, intVal);
-	    updateConnectedAlarmStatus(paramName, intVal, "Hi", epicsAlarmHigh, epicsSevMinor);
-	    updateConnectedAlarmStatus(paramName, intVal, "HiHi", epicsAlarmHiHi, epicsSevMajor);
-	    updateConnectedAlarmStatus(paramName, intVal, "Lo", epicsAlarmLow, epicsSevMinor);
-	    updateConnectedAlarmStatus(paramName, intVal, "LoLo", epicsAlarmLoLo, epicsSevMajor);
+		if (item->alarm.parent != NULL)
+		{
+	        updateConnectedAlarmStatus(item, intVal);
+		}
 	}
-	else if (m_params[paramName]->type == "string" || m_params[paramName]->type == "timestamp")
+	else if (item->type == "int64" || item->type == "uint64")
 	{
-	    m_driver->setStringParam(param_index, convertToPtr<char>(val));
+	    m_driver->setInteger64Param(param_index, convertToScalar<epicsInt64>(val));
+	}
+	else if (item->type == "longstring")
+	{
+		updateLongStringValue(param_index, item, convertToPtr<char>(val));
+	}
+	else if (item->type == "string" || item->type == "timestamp")
+	{
+		const char* sval = convertToPtr<char>(val);
+		std::string& string_value = item->string_value;
+		string_value.assign(sval != NULL ? sval : "");
+	    m_driver->setStringParam(param_index, string_value);
 	}
 	else
 	{
-	    std::cerr << "updateParamValue: unknown type \"" << m_params[paramName]->type << "\" for param \"" << paramName << "\"" << std::endl;
+	    std::cerr << "updateParamValue: unknown type \"" << item->type << "\" for param \"" << paramName << "\"" << std::endl;
 	}
 	if (do_asyn_param_callbacks)
 	{
@@ -628,18 +1916,115 @@ void NetShrVarInterface::updateParamValue(int param_index, T val, epicsTimeStamp
 	m_driver->unlock();
 }
 
+/// transpose a row major \a nrows x \a ncols array, working in blocks to be kinder to the cache for large arrays
+template<typename U>
+static void transposeArray(const U* in, U* out, size_t nrows, size_t ncols)
+{
+	static const size_t block = 32;
+	for(size_t r0=0; r0<nrows; r0 += block)
+	{
+		size_t r1 = std::min(r0 + block, nrows);
+		for(size_t c0=0; c0<ncols; c0 += block)
+		{
+			size_t c1 = std::min(c0 + block, ncols);
+			for(size_t r=r0; r<r1; ++r)
+			{
+				for(size_t c=c0; c<c1; ++c)
+				{
+					out[c * nrows + r] = in[r * ncols + c];
+				}
+			}
+		}
+	}
+}
+
+/// Buffers for decoding and converting array updates. These keep their capacity between updates, so we only allocate
+/// when an array grows, and there is one set per thread rather than per item as an item can be updated from several 
+/// threads at once e.g. by a subscriber update while the poll thread processes a #NvItem::RateLimit::max_rate deferred update
+/// or a single read. The threads that process updates last as long as the IOC, so these are never freed.
+struct ArrayScratch
+{
+	std::vector<char> decode_buffer; ///< receives data from CNVGetArrayDataValue()
+	std::vector<char> convert_buffer; ///< holds converted data when the shared variable element type differs from the asyn type
+	std::vector<char> transpose_buffer; ///< holds a transposed two dimensional array
+	/// the buffers for the calling thread
+	static ArrayScratch* forThread()
+	{
+		epicsThreadOnce(&once_id, createId, NULL);
+		ArrayScratch* scratch = static_cast<ArrayScratch*>(epicsThreadPrivateGet(private_id));
+		if (scratch == NULL)
+		{
+			scratch = new ArrayScratch;
+			epicsThreadPrivateSet(private_id, scratch);
+		}
+		return scratch;
+	}
+private:
+	static epicsThreadOnceId once_id;
+	static epicsThreadPrivateId private_id;
+	static void createId(void*) { private_id = epicsThreadPrivateCreate(); }
+};
+
+epicsThreadOnceId ArrayScratch::once_id = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId ArrayScratch::private_id = 0;
+
+/// publish an array update for \a item with the asyn type \a U. Any type conversion, transpose, statistics and preview are 
+/// done before the driver lock is taken, so with the #NVDispatchThreads option several arrays can be processed at once. 
+/// These use per thread buffers and locals, and the settings of \a item they need are copied with #m_params_lock held,
+/// so nothing in \a item is used or changed without a lock 
 template<typename T,typename U>
-void NetShrVarInterface::updateParamArrayValueImpl(int param_index, T* val, size_t nElements)
+void NetShrVarInterface::updateParamArrayValueImpl(int param_index, NvItem* item, T* val, size_t nElements, epicsTimeStamp* epicsTS, std::vector<size_t>& new_dims)
 {
 	const char *paramName = NULL;
 	m_driver->getParamName(param_index, &paramName);
-	std::vector<char>& array_data =  m_params[paramName]->array_data;
+	std::vector<char>& array_data =  item->array_data;
+	bool transpose, with_stats;
+	size_t preview_size;
+	{
+		epicsGuard<epicsMutex> _lock(m_params_lock);  // reloadConfig() may change these
+		transpose = item->shape.transpose;
+		with_stats = !item->stats.items.empty();
+		preview_size = (item->stats.preview_item != NULL ? item->stats.preview_size : 0);
+	}
 	U* eval = convertToPtr<U>(val);
+	if (eval == 0 && nElements > 0)
+	{
+		// element types differ e.g. a CNVDouble array published as float32array, so convert rather than copy 
+		std::vector<char>& convert_buffer = ArrayScratch::forThread()->convert_buffer;
+		convert_buffer.resize(nElements * sizeof(U));
+		if (convertArray(val, reinterpret_cast<U*>(&(convert_buffer[0])), nElements))
+		{
+			eval = reinterpret_cast<U*>(&(convert_buffer[0]));
+		}
+	}
 	if (eval != 0)
 	{
-		array_data.resize(nElements * sizeof(T));
-		memcpy(&(array_data[0]), eval, nElements * sizeof(T));
-		(m_driver->*C2CNV<U>::asyn_callback)(reinterpret_cast<U*>(&(array_data[0])), nElements, param_index, 0);
+		if (transpose && new_dims.size() == 2 && nElements > 0)
+		{
+			std::vector<char>& transpose_buffer = ArrayScratch::forThread()->transpose_buffer;
+			transpose_buffer.resize(nElements * sizeof(U));
+			transposeArray(eval, reinterpret_cast<U*>(&(transpose_buffer[0])), new_dims[0], new_dims[1]);
+			std::swap(new_dims[0], new_dims[1]);
+			eval = reinterpret_cast<U*>(&(transpose_buffer[0]));
+		}
+		// from the data as published, so a preview of a transposed array is in the transposed order
+		ArrayStats stats;
+		std::vector<epicsFloat64> preview;
+		bool stats_valid = computeArrayStats(with_stats, preview_size, static_cast<const U*>(eval), nElements, stats, preview);
+		m_driver->lock();
+		m_driver->setTimeStamp(epicsTS);
+		item->epicsTS = *epicsTS;
+		item->shape.dims.swap(new_dims);
+		array_data.resize(nElements * sizeof(U));
+		if (nElements > 0)
+		{
+			memcpy(&(array_data[0]), eval, nElements * sizeof(U));
+		}
+		doAsynArrayCallback(m_driver, C2CNV<U>::asyn_callback, &(array_data[0]), nElements, param_index);
+		updateArrayShape(item);
+		updateArrayStats(item, stats_valid, stats, preview);
+		updateSubArrays(item, reinterpret_cast<U*>(&(array_data[0])), nElements);
+		m_driver->unlock();
 	}
 	else
 	{
@@ -647,6 +2032,202 @@ void NetShrVarInterface::updateParamArrayValueImpl(int param_index, T* val, size
 	}
 }
 
+/// Publish a string shared variable value to a longstring (asynInt8Array) parameter, so it is not limited to the 40 characters 
+/// of an EPICS string. The characters and a terminating NULL are copied once from the CNV string into NvItem::array_data, 
+/// which keeps its capacity between updates. Called with m_driver locked 
+void NetShrVarInterface::updateLongStringValue(int param_index, NvItem* item, const char* val)
+{
+	if (val == NULL)
+	{
+		std::cerr << "updateLongStringValue: longstring param \"" << item->nv_name << "\" not given a string" << std::endl;
+		return;
+	}
+	size_t n = strlen(val) + 1;
+	std::vector<char>& array_data = item->array_data;
+	array_data.assign(val, val + n);
+	item->string_value.assign(val, n - 1);  // kept in step with array_data, see setValue()
+	m_driver->doCallbacksInt8Array(reinterpret_cast<epicsInt8*>(&(array_data[0])), n, param_index, 0);
+	updateBytesReadCount(static_cast<unsigned>(n));
+}
+
+/// publish array dimensions to the derived shape parameters, if requested and changed. Called with m_driver locked 
+void NetShrVarInterface::updateArrayShape(NvItem* item)
+{
+	if (item->shape.dims_item == NULL)
+	{
+		return;
+	}
+	std::vector<epicsInt32> dims(item->shape.dims.begin(), item->shape.dims.end());
+	std::vector<char>& dims_data = item->shape.dims_item->array_data;
+	item->shape.dims_item->epicsTS = item->epicsTS;
+	item->shape.ndims_item->epicsTS = item->epicsTS;
+	if (dims_data.size() == dims.size() * sizeof(epicsInt32) && (dims.size() == 0 || memcmp(&(dims_data[0]), &(dims[0]), dims_data.size()) == 0))
+	{
+		return;
+	}
+	dims_data.resize(dims.size() * sizeof(epicsInt32));
+	if (dims.size() > 0)
+	{
+		memcpy(&(dims_data[0]), &(dims[0]), dims_data.size());
+	}
+	m_driver->doCallbacksInt32Array(dims.size() > 0 ? reinterpret_cast<epicsInt32*>(&(dims_data[0])) : NULL, dims.size(), item->shape.dims_item->id, 0);
+	m_driver->setIntegerParam(item->shape.ndims_item->id, static_cast<int>(dims.size()));
+	m_driver->callParamCallbacks();
+}
+
+/// update any single element, slice, row or column parameters derived from an array parameter, only the referenced 
+/// part of the array is copied. Called with m_driver locked 
+template<typename U>
+void NetShrVarInterface::updateSubArrays(NvItem* item, U* val, size_t nElements)
+{
+	bool do_param_callbacks = false;
+	for(std::vector<NvItem*>::const_iterator it = item->sub.items.begin(); it != item->sub.items.end(); ++it)
+	{
+		NvItem* sub_item = *it;
+		sub_item->epicsTS = item->epicsTS;
+		if (sub_item->sub.kind == NvItem::SubElement)
+		{
+			if (sub_item->sub.start < nElements)
+			{
+				if (sub_item->type == "float64")
+				{
+					m_driver->setDoubleParam(sub_item->id, convertToScalar<double>(val[sub_item->sub.start]));
+				}
+				else if (sub_item->type == "int64")
+				{
+					m_driver->setInteger64Param(sub_item->id, convertToScalar<epicsInt64>(val[sub_item->sub.start]));
+				}
+				else
+				{
+					m_driver->setIntegerParam(sub_item->id, convertToScalar<int>(val[sub_item->sub.start]));
+				}
+				m_driver->setParamStatus(sub_item->id, asynSuccess);
+			}
+			else
+			{
+				m_driver->setParamStatus(sub_item->id, asynError);
+			}
+			do_param_callbacks = true;
+		}
+		else
+		{
+			size_t first = 0, n = 0, stride = 1;
+			if (sub_item->sub.kind == NvItem::SubSlice)
+			{
+				first = std::min(sub_item->sub.start, nElements);
+				n = std::min(sub_item->sub.len, nElements - first);
+			}
+			else if (item->shape.dims.size() == 2 && sub_item->sub.kind == NvItem::SubRow && sub_item->sub.start < item->shape.dims[0])
+			{
+				first = sub_item->sub.start * item->shape.dims[1];
+				n = item->shape.dims[1];
+			}
+			else if (item->shape.dims.size() == 2 && sub_item->sub.kind == NvItem::SubColumn && sub_item->sub.start < item->shape.dims[1])
+			{
+				first = sub_item->sub.start;
+				n = item->shape.dims[0];
+				stride = item->shape.dims[1];
+			}
+			std::vector<char>& array_data = sub_item->array_data;
+			array_data.resize(n * sizeof(U));
+			if (n > 0 && stride == 1)
+			{
+				memcpy(&(array_data[0]), val + first, n * sizeof(U));
+			}
+			else if (n > 0)
+			{
+				U* sub_val = reinterpret_cast<U*>(&(array_data[0]));
+				for(size_t i=0; i<n; ++i)
+				{
+					sub_val[i] = val[first + i * stride];
+				}
+			}
+			doAsynArrayCallback(m_driver, C2CNV<U>::asyn_callback, (n > 0 ? static_cast<void*>(&(array_data[0])) : static_cast<void*>(val)), n, sub_item->id);
+		}
+	}
+	if (do_param_callbacks)
+	{
+		m_driver->callParamCallbacks();
+	}
+}
+
+/// update sub array parameters of \a item from its currently cached array data. Called with m_driver locked
+void NetShrVarInterface::updateSubArraysFromCache(NvItem* item)
+{
+	std::vector<char>& array_data = item->array_data;
+	if (array_data.size() == 0)
+	{
+		return;
+	}
+	if (item->type == "float64array")
+	{
+		updateSubArrays(item, reinterpret_cast<epicsFloat64*>(&(array_data[0])), array_data.size() / sizeof(epicsFloat64));
+	}
+	else if (item->type == "float32array")
+	{
+		updateSubArrays(item, reinterpret_cast<epicsFloat32*>(&(array_data[0])), array_data.size() / sizeof(epicsFloat32));
+	}
+	else if (item->type == "int32array")
+	{
+		updateSubArrays(item, reinterpret_cast<epicsInt32*>(&(array_data[0])), array_data.size() / sizeof(epicsInt32));
+	}
+	else if (item->type == "int16array")
+	{
+		updateSubArrays(item, reinterpret_cast<epicsInt16*>(&(array_data[0])), array_data.size() / sizeof(epicsInt16));
+	}
+	else if (item->type == "int8array")
+	{
+		updateSubArrays(item, reinterpret_cast<epicsInt8*>(&(array_data[0])), array_data.size() / sizeof(epicsInt8));
+	}
+	else if (item->type == "int64array" || item->type == "uint64array")
+	{
+		updateSubArrays(item, reinterpret_cast<__int64*>(&(array_data[0])), array_data.size() / sizeof(__int64));
+	}
+}
+
+/// compute statistics of \a val into \a stats if \a with_stats and a preview of \a preview_size points (0 for none) 
+/// into \a preview, ready for updateArrayStats()
+/// \return true if \a stats were computed
+template<typename T>
+bool NetShrVarInterface::computeArrayStats(bool with_stats, size_t preview_size, const T* val, size_t nElements, ArrayStats& stats, std::vector<epicsFloat64>& preview)
+{
+	if (preview_size > 0)
+	{
+		preview.resize(preview_size);
+		size_t n = decimateArray(val, nElements, &(preview[0]), preview_size);
+		preview.resize(n);
+	}
+	return (with_stats && ::computeArrayStats(val, nElements, stats));
+}
+
+/// update any statistics and preview parameters derived from an array parameter from the values 
+/// calculated by computeArrayStats(). Called with m_driver locked 
+void NetShrVarInterface::updateArrayStats(NvItem* item, bool stats_valid, const ArrayStats& stats, const std::vector<epicsFloat64>& preview)
+{
+	if (stats_valid && item->stats.items.size() == ArrayStats::NStats)  // reloadConfig() may have changed them since computeArrayStats()
+	{
+		for(int i=0; i<ArrayStats::NStats; ++i)
+		{
+			NvItem* stats_item = item->stats.items[i];
+			stats_item->epicsTS = item->epicsTS;
+			m_driver->setDoubleParam(stats_item->id, stats.value(i));
+		}
+		m_driver->callParamCallbacks();
+	}
+	if (item->stats.preview_item != NULL)
+	{
+		std::vector<char>& preview_data = item->stats.preview_item->array_data;
+		size_t n = preview.size();
+		preview_data.resize(n * sizeof(epicsFloat64));
+		if (n > 0)
+		{
+			memcpy(&(preview_data[0]), &(preview[0]), n * sizeof(epicsFloat64));
+		}
+		item->stats.preview_item->epicsTS = item->epicsTS;
+		m_driver->doCallbacksFloat64Array(n > 0 ? reinterpret_cast<epicsFloat64*>(&(preview_data[0])) : NULL, n, item->stats.preview_item->id, 0);
+	}
+}
+
 // labview timestamp is seconds since 01-01-1904 00:00:00
 // epics timestamp epoch is seconds since 01-01-1990 00:00:00
 static void convertLabviewTimeToEpicsTime(const uint64_t* lv_time, epicsTimeStamp* epicsTS)
@@ -658,22 +2239,29 @@ static void convertLabviewTimeToEpicsTime(const uint64_t* lv_time, epicsTimeStam
 }
 
 template<typename T>
-void NetShrVarInterface::updateParamArrayValue(int param_index, T* val, size_t nElements, epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks)
+void NetShrVarInterface::updateParamArrayValue(int param_index, T* val, size_t nElements, const size_t* dims, unsigned nDims,
+                                                  epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks)
 {
 	const char *paramName = NULL;
     epicsTimeStamp epicsTSv;
 	m_driver->getParamName(param_index, &paramName);
-    bool with_ts = m_params[paramName]->with_ts;
+	NvItem* item = findItem(paramName);
+    bool with_ts = item->with_ts;
+	std::vector<size_t> new_dims(dims, dims + nDims);
     if (with_ts) // first 128bits of data are timestamp
     {
         size_t n_ts_elem = 16 / sizeof(T);
         const uint64_t* time_data = reinterpret_cast<const uint64_t*>(val);
         if (nElements > n_ts_elem)
         {
-            convertLabviewTimeToEpicsTime(time_data, &epicsTSv);
+			if (item->ts_source == NvTsEmbedded)
+			{
+                convertLabviewTimeToEpicsTime(time_data, &epicsTSv);
+                epicsTS = &epicsTSv;
+			}
             val += n_ts_elem;
             nElements -= n_ts_elem;
-            epicsTS = &epicsTSv;
+            new_dims.assign(1, nElements); // shape is not meaningful with an embedded timestamp
         }
         else
         {
@@ -681,37 +2269,49 @@ void NetShrVarInterface::updateParamArrayValue(int param_index, T* val, size_t n
             return;
         }
     }
-	m_driver->lock();
-	m_driver->setTimeStamp(epicsTS);
-	m_params[paramName]->epicsTS = *epicsTS;
-	if (m_params[paramName]->type == "float64array")
+	// array types take the driver lock themselves, after doing any conversion 
+	if (item->type == "float64array")
+	{
+		updateParamArrayValueImpl<T,epicsFloat64>(param_index, item, val, nElements, epicsTS, new_dims);
+		return;
+	}
+	else if (item->type == "float32array")
 	{
-		updateParamArrayValueImpl<T,epicsFloat64>(param_index, val, nElements);
+		updateParamArrayValueImpl<T,epicsFloat32>(param_index, item, val, nElements, epicsTS, new_dims);
+		return;
 	}
-	else if (m_params[paramName]->type == "float32array")
+	else if (item->type == "int32array")
 	{
-		updateParamArrayValueImpl<T,epicsFloat32>(param_index, val, nElements);
+		updateParamArrayValueImpl<T,epicsInt32>(param_index, item, val, nElements, epicsTS, new_dims);
+		return;
 	}
-	else if (m_params[paramName]->type == "int32array")
+	else if (item->type == "int16array")
 	{
-		updateParamArrayValueImpl<T,epicsInt32>(param_index, val, nElements);
+		updateParamArrayValueImpl<T,epicsInt16>(param_index, item, val, nElements, epicsTS, new_dims);
+		return;
 	}
-	else if (m_params[paramName]->type == "int16array")
+	else if (item->type == "int8array" || item->type == "longstring") // a longstring can also be given a LabVIEW byte array
 	{
-		updateParamArrayValueImpl<T,epicsInt16>(param_index, val, nElements);
+		updateParamArrayValueImpl<T,epicsInt8>(param_index, item, val, nElements, epicsTS, new_dims);
+		return;
 	}
-	else if (m_params[paramName]->type == "int8array")
+	else if (item->type == "int64array" || item->type == "uint64array") // asyn does not have unsigned types, so we pass uint64 as int64
 	{
-		updateParamArrayValueImpl<T,epicsInt8>(param_index, val, nElements);
+		updateParamArrayValueImpl<T,__int64>(param_index, item, val, nElements, epicsTS, new_dims);
+		return;
 	}
-	else if (m_params[paramName]->type == "timestamp" || m_params[paramName]->type == "ftimestamp") // this is an array of two uint64 elements 
+	m_driver->lock();
+	m_driver->setTimeStamp(epicsTS);
+	item->epicsTS = *epicsTS;
+	item->shape.dims.swap(new_dims);
+	if (item->type == "timestamp" || item->type == "ftimestamp") // this is an array of two uint64 elements 
 	{
         if ( nElements == 2 && sizeof(T) == sizeof(uint64_t) )
         {
             uint64_t* time_data = reinterpret_cast<uint64_t*>(val);
             convertLabviewTimeToEpicsTime(time_data, epicsTS);
 	        // we do not need to call m_driver->setTimeStamp(epicsTS) etc as this is done in updateParamValue
-            if (m_params[paramName]->type == "timestamp")
+            if (item->type == "timestamp")
             {                
                 char time_buffer[40]; // max size of epics simple string type
                 epicsTimeToStrftime(time_buffer, sizeof(time_buffer), "%Y-%m-%dT%H:%M:%S.%06f", epicsTS);
@@ -730,35 +2330,86 @@ void NetShrVarInterface::updateParamArrayValue(int param_index, T* val, size_t n
 	}
 	else
 	{
-	    std::cerr << "updateParamArrayValue: unknown type \"" << m_params[paramName]->type << "\" for param \"" << paramName << "\"" << std::endl;
+	    std::cerr << "updateParamArrayValue: unknown type \"" << item->type << "\" for param \"" << paramName << "\"" << std::endl;
 	}
 	m_driver->unlock();
 }
 
-/// called externally with m_driver locked
-template <typename T> 
-void NetShrVarInterface::readArrayValue(const char* paramName, T* value, size_t nElements, size_t* nIn)
+/// Read the value of a single read (SR) parameter, called with m_driver locked. If the last value read is less than
+/// NvItem::SingleReadState::max_age seconds old it is used rather than reading again. If a read of the same variable is already in progress 
+/// (the driver lock is released while reading) we wait for that read to finish and use its value rather than reading 
+/// again, so several records scanning the same variable only cause one network read at a time but each still sees
+/// a value read after it asked.
+void NetShrVarInterface::singleRead(const char* paramName, NvItem* item, bool is_array)
 {
-	NvItem* item = m_params[paramName];
-	if (item->access & NvItem::SingleRead)
+	static const double read_wait_timeout = 5.0;  // much longer than the CNVRead() timeout below 
+	if (item->reader == NULL)
 	{
-        ScopedCNVData cvalue;
-		if (item->reader != NULL)
+		std::cerr << "NetShrVarInterface::singleRead: Param \"" << paramName << "\" (" << item->nv_name << ") is not valid" << std::endl;
+		return;
+	}
+	if (item->sr.in_progress)
+	{
+		++(item->sr.n_coalesced);
+		unsigned long n_reads = item->sr.n_reads;
+		epicsTimeStamp start, now;
+		epicsTimeGetCurrent(&start);
+		now = start;
+		while(item->sr.n_reads == n_reads && epicsTimeDiffInSeconds(&now, &start) < read_wait_timeout)
 		{
-			m_driver->unlock(); // to allow DataCallback to work while we try and read
-			int status = CNVRead(item->reader, 10, &cvalue);
+			m_driver->unlock();
+			item->sr.done.wait(read_wait_timeout - epicsTimeDiffInSeconds(&now, &start));
 			m_driver->lock();
-			ERROR_CHECK("CNVRead", status);
-			if (status > 0) // 0 means no new value, 1 means a new value since last read
-			{
-				updateParamCNV(item->id, cvalue, NULL, false);  ///< @todo or true?	and set timestamp below?	
-			}
+			epicsTimeGetCurrent(&now);
 		}
-		else
+		if (item->sr.n_reads == n_reads)
+		{
+			throw std::runtime_error("singleRead: timed out waiting for the read in progress of \"" + item->nv_name + "\"");
+		}
+		item->sr.done.signal();  // pass it on, there may be other requests waiting for the same read 
+		ERROR_CHECK("CNVRead", item->sr.status);
+		return;
+	}
+	epicsTimeStamp now;
+	epicsTimeGetCurrent(&now);
+	if (item->sr.max_age > 0.0 && item->sr.n_reads > 0 && epicsTimeDiffInSeconds(&now, &(item->sr.last_read)) < item->sr.max_age)
+	{
+		++(item->sr.n_cached);
+		return;
+	}
+	ScopedCNVData cvalue;
+	item->sr.in_progress = true;
+	m_driver->unlock(); // to allow DataCallback to work while we try and read
+	int status = CNVRead(item->reader, 10, &cvalue);
+	m_driver->lock();
+	item->sr.in_progress = false;
+	item->sr.status = status;
+	++(item->sr.n_reads);
+	item->sr.done.signal();
+	ERROR_CHECK("CNVRead", status);
+	item->sr.last_read = now;
+	if (is_array)
+	{
+		if (status > 0) // 0 means no new value, 1 means a new value since last read
 		{
-			std::cerr << "NetShrVarInterface::readArrayValue: Param \"" << paramName << "\" (" << item->nv_name << ") is not valid" << std::endl;
+			updateParamCNV(item->id, cvalue, NULL, false);  ///< @todo or true?	and set timestamp below?	
 		}
 	}
+	else if (cvalue != 0)
+	{
+		updateParamCNV(item->id, cvalue, NULL, true);
+	}
+}
+
+/// called externally with m_driver locked
+template <typename T> 
+void NetShrVarInterface::readArrayValue(const char* paramName, T* value, size_t nElements, size_t* nIn)
+{
+	NvItem* item = findActiveItem(paramName);
+	if (item->access & NvItem::SingleRead)
+	{
+		singleRead(paramName, item, true);
+	}
 	std::vector<char>& array_data =  item->array_data;
 	size_t n = array_data.size() / sizeof(T);
 	if (n > nElements)
@@ -767,31 +2418,16 @@ void NetShrVarInterface::readArrayValue(const char* paramName, T* value, size_t
 	}
 	*nIn = n;
 	memcpy(value, &(array_data[0]), n * sizeof(T));
-	m_driver->setTimeStamp(&(m_params[paramName]->epicsTS));
+	m_driver->setTimeStamp(&(item->epicsTS));
 }
 
 /// read a value and update corresponding asyn parameter
 void NetShrVarInterface::readValue(const char* param)
 {
-	NvItem* item = m_params[param];
+	NvItem* item = findActiveItem(param);
 	if (item->access & NvItem::SingleRead)
 	{
-        ScopedCNVData cvalue;
-		if (item->reader != NULL)
-		{
-			m_driver->unlock(); // to allow DataCallback to work while we try and read
-			int status = CNVRead(item->reader, 10, &cvalue);
-			m_driver->lock();
-			ERROR_CHECK("CNVRead", status);
-			if (cvalue != 0)
-			{
-				updateParamCNV(item->id, cvalue, NULL, true);
-			}
-		}
-		else
-		{
-			std::cerr << "NetShrVarInterface::readValue: Param \"" << param << "\" (" << item->nv_name << ") is not valid" << std::endl;
-		}
+		singleRead(param, item, false);
 	}
 //	m_driver->setTimeStamp(&(m_params[paramName]->epicsTS)); // don't think this is needed
 }
@@ -801,6 +2437,7 @@ void NetShrVarInterface::updateParamCNVImpl(int param_index, CNVData data, CNVDa
                    epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks)
 {
 	static const int maxDims = 10;
+	typedef typename CNV2C<cnvType>::ctype ctype;
 	if (nDims == 0)
 	{
 	    typename CNV2C<cnvType>::ctype val;
@@ -808,11 +2445,11 @@ void NetShrVarInterface::updateParamCNVImpl(int param_index, CNVData data, CNVDa
 	    ERROR_CHECK("CNVGetScalarDataValue", status);
 	    updateParamValue(param_index, val, epicsTS, do_asyn_param_callbacks);
         CNV2C<cnvType>::free(val);
-        updateBytesReadCount(sizeof(CNV2C<cnvType>::ctype));
+        updateBytesReadCount(sizeof(typename CNV2C<cnvType>::ctype));
 	}
 	else if (nDims <= maxDims)
 	{
-	    typename CNV2C<cnvType>::ctype* val = NULL;
+	    std::vector<char>& decode_buffer = ArrayScratch::forThread()->decode_buffer;
 	    size_t dimensions[maxDims];
 	    int status = CNVGetArrayDataDimensions(data, nDims, dimensions);
 	    ERROR_CHECK("CNVGetArrayDataDimensions", status);
@@ -823,15 +2460,12 @@ void NetShrVarInterface::updateParamCNVImpl(int param_index, CNVData data, CNVDa
 		}
 		if (nElements > 0)
 		{
-		    val = new typename CNV2C<cnvType>::ctype[nElements];
-			if (val != NULL)
-			{
-		        status = CNVGetArrayDataValue(data, type, val, nElements);
-	            ERROR_CHECK("CNVGetArrayDataValue", status);
-	            updateParamArrayValue(param_index, val, nElements, epicsTS, do_asyn_param_callbacks);
-		        delete[] val;
-                updateBytesReadCount(nElements * sizeof(CNV2C<cnvType>::ctype));
-			}
+		    decode_buffer.resize(nElements * sizeof(ctype));
+		    ctype* val = reinterpret_cast<ctype*>(&(decode_buffer[0]));
+		    status = CNVGetArrayDataValue(data, type, val, nElements);
+	        ERROR_CHECK("CNVGetArrayDataValue", status);
+	        updateParamArrayValue(param_index, val, nElements, dimensions, nDims, epicsTS, do_asyn_param_callbacks);
+            updateBytesReadCount(nElements * sizeof(ctype));
 		}
 	}
 }
@@ -890,24 +2524,57 @@ void NetShrVarInterface::updateParamCNV (int param_index, CNVData data, epicsTim
 	ERROR_CHECK("CNVGetDataType", status);
     // the update time for an item in a shared variable structure/cluster is the upadate time of the structure variable
     // so we need to propagate the structure time when we recurse into its fields
-	const std::string& ts_param = m_params[paramName]->ts_param;
-	if (ts_param.size() > 0)
+	NvItem* this_item = findItem(paramName);
+	if (this_item->restored)
+	{
+		this_item->restored = false;  // live data replaces the value from the snapshot, so clear its alarm
+		setParamStatus(param_index, asynSuccess);
+	}
+	if (this_item->ts_source == NvTsLinked)
 	{
-		epicsTS = &(m_params[ts_param]->epicsTS);
+		epicsTS = &(findItem(this_item->ts_param)->epicsTS);
 	}
 	if (epicsTS == NULL)
     {
-        status = CNVGetDataUTCTimestamp(data, &timestamp);
-	    ERROR_CHECK("CNVGetDataUTCTimestamp", status);
-	    if (!convertTimeStamp(timestamp, &epicsTSLocal))
-        {
-            epicsTimeGetCurrent(&epicsTSLocal);
-        }
+		switch(this_item->ts_source)
+		{
+			case NvTsNone:  // keep the time of the first update, rather than publishing the zero (1990) time we start with
+				if (this_item->epicsTS.secPastEpoch == 0 && this_item->epicsTS.nsec == 0)
+				{
+					epicsTimeGetCurrent(&(this_item->epicsTS));
+				}
+			    epicsTSLocal = this_item->epicsTS;
+				break;
+
+			case NvTsEmbedded:  // replaced by the embedded time in updateParamArrayValue()
+			    epicsTSLocal = this_item->epicsTS;
+				break;
+				
+			case NvTsLocalReceive:
+			    epicsTimeGetCurrent(&epicsTSLocal);
+				break;
+				
+			default:
+				status = CNVGetDataUTCTimestamp(data, &timestamp);
+				ERROR_CHECK("CNVGetDataUTCTimestamp", status);
+				if (!convertTimeStamp(timestamp, &epicsTSLocal))
+				{
+					epicsTimeGetCurrent(&epicsTSLocal);
+				}
+				else if (this_item->host_clock != NULL)
+				{
+					epicsTimeStamp now;
+					epicsTimeGetCurrent(&now);
+					this_item->host_clock->update(epicsTSLocal, now);
+					this_item->host_clock->correct(epicsTSLocal);
+				}
+				break;
+		}
         epicsTS = &epicsTSLocal;
     }
 	if (type == CNVStruct)
 	{
-		int field = m_params[paramName]->field;
+		int field = this_item->field;
 	    status = CNVGetNumberOfStructFields(data, &numberOfFields);
 		ERROR_CHECK("CNVGetNumberOfStructFields", status);
 		if (numberOfFields == 0)
@@ -923,30 +2590,36 @@ void NetShrVarInterface::updateParamCNV (int param_index, CNVData data, epicsTim
 		ERROR_CHECK("CNVGetStructFields", status);
 		// loop round all params interested in this structure
 		// i.e. not just param_index and field
-		const std::string& this_nv = m_params[paramName]->nv_name;
+		const std::string& this_nv = this_item->nv_name;
 		// we so timestamp fields first so if we are linked to them
 		// via ts_param then we get the correct time value applied later
-		std::vector<const NvItem*> items_left;
+		std::vector< std::pair<int,int> > ts_items, items_left;  // asyn parameter id and field index
 		items_left.reserve(numberOfFields);
-		for (params_t::iterator it = m_params.begin(); it != m_params.end(); ++it)
 		{
-			NvItem* item = it->second;
-			if (item->field != -1 && item->nv_name == this_nv)   
+			epicsGuard<epicsMutex> _lock(m_params_lock);  // reloadConfig() may be changing other items
+			for (params_t::const_iterator it = m_params.begin(); it != m_params.end(); ++it)
 			{
-				if (item->type == "timestamp" || item->type == "ftimestamp")
+				const NvItem* item = it->second;
+				if (item->field != -1 && item->field < numberOfFields && item->nv_name == this_nv)   
 				{
-					updateParamCNV(item->id, fields[item->field], NULL, do_asyn_param_callbacks);
-				}
-				else
-				{
-					items_left.push_back(item);
+					if (item->type == "timestamp" || item->type == "ftimestamp")
+					{
+						ts_items.push_back(std::pair<int,int>(item->id, item->field));
+					}
+					else
+					{
+						items_left.push_back(std::pair<int,int>(item->id, item->field));
+					}
 				}
 			}
 		}
-		for (std::vector<const NvItem*>::const_iterator it = items_left.begin(); it != items_left.end(); ++it)
+		for (std::vector< std::pair<int,int> >::const_iterator it = ts_items.begin(); it != ts_items.end(); ++it)
+		{
+			updateParamCNV(it->first, fields[it->second], NULL, do_asyn_param_callbacks);
+		}
+		for (std::vector< std::pair<int,int> >::const_iterator it = items_left.begin(); it != items_left.end(); ++it)
 		{
-			const NvItem* item = *it;
-			updateParamCNV(item->id, fields[item->field], epicsTS, do_asyn_param_callbacks);
+			updateParamCNV(it->first, fields[it->second], epicsTS, do_asyn_param_callbacks);
 		}
         for(int i=0; i<numberOfFields; ++i)
         {
@@ -988,11 +2661,11 @@ void NetShrVarInterface::updateParamCNV (int param_index, CNVData data, epicsTim
 		// we did try alarming here if not otherwise in alarm, but the connected alarms do not repeat
 		// so you can get race conditions and conflict especially if you gaev buffered readers for one
 		// and readers for the other
-		if (!(m_params[paramName]->connected_alarm))
+		if (!(this_item->alarm.connected))
 		{
 		    if (p_stat == asynSuccess && p_alarmStat == epicsAlarmNone && p_alarmSevr == epicsSevNone)
 		    {
-				std::cerr << "Unexpected Alarm for " << m_params[paramName]->nv_name << " - Alarming enabled after IOC started?" << std::endl;
+				std::cerr << "Unexpected Alarm for " << this_item->nv_name << " - Alarming enabled after IOC started?" << std::endl;
  			    std::cerr << "Raising generic HWLIMIT/MINOR Alarm for \"" << paramName << "\"" << std::endl;
  			    std::cerr << "(For more specific HI/LOW etc alarms start this IOC after enabling Alarming)" << std::endl;
 	            setParamStatus(param_index, asynSuccess, epicsAlarmHwLimit, epicsSevMinor);
@@ -1095,6 +2768,17 @@ void NetShrVarInterface::statusCallback (void * handle, CNVConnectionStatus stat
 	else
 	{
 		std::cerr << "StatusCallback: " << cb_data->nv_name << " is " << connectionStatus(status) << std::endl;
+		NvItem* item = cb_data->item;
+		m_driver->lock();
+		if (status == CNVDisconnected && item->conn.state != NvItem::ConnDisconnected)
+		{
+			++(item->conn.n_disconnects);
+		}
+		if (item->conn.state != NvItem::ConnFailed)  // a connection that failed to be created stays failed until healthMonitor() retries it
+		{
+		    item->conn.state = (status == CNVConnected ? NvItem::ConnConnected : (status == CNVConnecting ? NvItem::ConnConnecting : NvItem::ConnDisconnected));
+		}
+		m_driver->unlock();
 	    if (status != CNVConnected)
 	    {
 		    setParamStatus(cb_data->param_index, asynDisconnected);
@@ -1120,6 +2804,7 @@ char* NetShrVarInterface::envExpand(const char *str)
     long destCapacity = 128;
     char *dest = NULL;
     int n;
+    epicsGuard<epicsMutex> _lock(m_env->lock);
     do {
         destCapacity *= 2;
         /*
@@ -1128,7 +2813,7 @@ char* NetShrVarInterface::envExpand(const char *str)
          */
         free(dest);
         dest = static_cast<char*>(mallocMustSucceed(destCapacity, "NetShrVarInterface::envExpand"));
-        n = macExpandString(m_mac_env, str, dest, destCapacity);
+        n = macExpandString(m_env->mac_env, str, dest, destCapacity);
     } while (n >= (destCapacity - 1));
     if (n < 0) {
         free(dest);
@@ -1146,255 +2831,1060 @@ char* NetShrVarInterface::envExpand(const char *str)
 /// \param[in] configFile @copydoc initArg2
 /// \param[in] options @copydoc initArg4
 NetShrVarInterface::NetShrVarInterface(const char *configSection, const char* configFile, int options) : 
-				m_configSection(configSection), m_options(options), m_mac_env(NULL), 
+				m_configSection(configSection), m_options(options), m_groups_expanded(false), 
 				m_writer_wait_ms(5000/*also CNVWaitForever or CNVDoNotWait*/), 
-				m_b_writer_wait_ms(CNVDoNotWait/*also CNVWaitForever or CNVDoNotWait*/),
+				m_b_writer_wait_ms(CNVDoNotWait/*also CNVWaitForever or CNVDoNotWait*/), m_dispatcher(NULL), m_snapshot_period(10.0), 
+				m_reconnect_min(1.0), m_reconnect_max(60.0), m_shutting_down(false),
                 m_items_read(0), m_bytes_read(0)
 {
     ftime(&m_last_report);
 	epicsThreadOnce(&onceId, initCV, NULL);
-	// load current environment into m_mac_env, this is so we can create a macEnvExpand() equivalent 
+	// snapshot current environment into m_env, this is so we can create a macEnvExpand() equivalent 
 	// but tied to the environment at a specific time. It is useful if we want to load the same 
-	// XML file twice but with a macro defined differently in each case 
-	if (macCreateHandle(&m_mac_env, NULL) != 0)
+	// XML file twice but with a macro defined differently in each case. Ports configured
+	// with an unchanged environment share the same snapshot
+	m_env = getEnvSnapshot();
+	char* configFile_expanded = envExpand(configFile);
+	m_configFile = configFile_expanded;
+	free(configFile_expanded);
+	epicsAtExit(epicsExitFunc, this);
+
+	try
+	{
+	    m_config = loadConfigFile(m_configFile, false);  // only parsed once if several ports use the same file
+	}
+	catch(const std::exception& ex)
+	{
+		throw std::runtime_error(std::string(ex.what()) + " (expanded from \"" + configFile + "\")");
+	}
+	std::cerr << "Loaded XML config file \"" << m_configFile << "\" (expanded from \"" << configFile << "\")" << std::endl;
+	if (checkOption(NVDispatchThreads) || checkOption(NVPublisherThread))
+	{
+		// default to one worker thread per CPU, can be changed with NETSHRVAR_DISPATCH_THREADS environment variable
+		int nthreads = 1;
+		if (checkOption(NVDispatchThreads))
+		{
+		    nthreads = getenv("NETSHRVAR_DISPATCH_THREADS") != NULL ? atoi(getenv("NETSHRVAR_DISPATCH_THREADS")) : epicsThreadGetCPUs();
+		}
+		int queue_size = getenv("NETSHRVAR_QUEUE_SIZE") != NULL ? atoi(getenv("NETSHRVAR_QUEUE_SIZE")) : 1024;
+		m_dispatcher = new NvDispatcher(m_configSection, nthreads, DispatchedDataCallback, (queue_size > 0 ? queue_size : 1024),
+		                     (checkOption(NVDropNewest) ? NvDispatcher::DropNewest : NvDispatcher::DropOldest));
+	}
+	// retry delays (seconds) for failed connections, a maximum of 0 disables retries 
+	if (getenv("NETSHRVAR_RECONNECT_MIN") != NULL && atof(getenv("NETSHRVAR_RECONNECT_MIN")) > 0.0)
+	{
+		m_reconnect_min = atof(getenv("NETSHRVAR_RECONNECT_MIN"));
+	}
+	if (getenv("NETSHRVAR_RECONNECT_MAX") != NULL)
+	{
+		m_reconnect_max = atof(getenv("NETSHRVAR_RECONNECT_MAX"));
+	}
+	// parameter values are saved to, and restored at startup from, a file named after our section in this directory 
+	if (getenv("NETSHRVAR_SNAPSHOT_DIR") != NULL && *getenv("NETSHRVAR_SNAPSHOT_DIR") != '\0')
+	{
+		m_snapshot_file = std::string(getenv("NETSHRVAR_SNAPSHOT_DIR")) + "/" + m_configSection + ".snap";
+		if (getenv("NETSHRVAR_SNAPSHOT_PERIOD") != NULL && atof(getenv("NETSHRVAR_SNAPSHOT_PERIOD")) > 0.0)
+		{
+			m_snapshot_period = atof(getenv("NETSHRVAR_SNAPSHOT_PERIOD"));
+		}
+	}
+}
+
+NetShrVarInterface::~NetShrVarInterface()
+{
+	stopThreads();
+	delete m_dispatcher;
+}
+
+/// ask our background threads to stop and wait for them to exit, as they use this object and #m_driver. They 
+/// take the driver lock, so must not be called with it held. A thread may be in the middle of a network operation, 
+/// so this can take a few seconds
+void NetShrVarInterface::stopThreads()
+{
+	m_shutting_down = true;
+	ThreadControl* threads[] = { &m_sr_polling, &m_snapshot_thread, &m_health_monitor };
+	for(size_t i=0; i<sizeof(threads) / sizeof(threads[0]); ++i)
+	{
+		if (threads[i]->started)
+		{
+			threads[i]->started = false;
+			threads[i]->wake.signal();
+			threads[i]->done.wait();
+		}
+	}
+}
+
+// need to be careful here as might get called at wrong point. May need to check with driver.
+void NetShrVarInterface::epicsExitFunc(void* arg)
+{
+	NetShrVarInterface* netvarint = static_cast<NetShrVarInterface*>(arg);
+	bool write_snapshot = (netvarint != NULL && netvarint->m_snapshot_thread.started);  // so we know the driver was created
+	if (netvarint != NULL)
+	{
+		netvarint->stopThreads();  // before CNVFinish(), as they use the NI library
+	}
+	if (netvarint != NULL && netvarint->m_dispatcher != NULL)
+	{
+		netvarint->m_dispatcher->stop();
+	}
+	if (write_snapshot)
+	{
+		try
+		{
+			netvarint->writeSnapshot();
+		}
+		catch(const std::exception& ex)
+		{
+			std::cerr << "epicsExitFunc: " << ex.what() << std::endl;
+		}
+	}
+    CNVFinish();
+}
+
+size_t NetShrVarInterface::nParams()
+{
+	const NvSectionConfig* section = m_config->section(m_configSection);
+	expandParamGroups();
+	return (section != NULL ? section->size() : 0) + m_group_params.size();
+}
+
+/// the asyn parameter type to use for a shared variable of type \a type with \a nDims dimensions, NULL if not supported
+static const char* inferParamType(CNVDataType type, unsigned nDims)
+{
+	switch(type)
+	{
+		case CNVBool:
+			return (nDims == 0 ? "boolean" : "int8array");
+		case CNVString:
+			return (nDims == 0 ? "string" : NULL);
+		case CNVSingle:
+			return (nDims == 0 ? "float32" : "float32array");
+		case CNVDouble:
+			return (nDims == 0 ? "float64" : "float64array");
+		case CNVInt8:
+		case CNVUInt8:
+			return (nDims == 0 ? "int32" : "int8array");
+		case CNVInt16:
+		case CNVUInt16:
+			return (nDims == 0 ? "int32" : "int16array");
+		case CNVInt32:
+		case CNVUInt32:
+			return (nDims == 0 ? "int32" : "int32array");
+		case CNVInt64:
+			return (nDims == 0 ? "int64" : "int64array");
+		case CNVUInt64:
+			return (nDims == 0 ? "uint64" : "uint64array");
+		default:
+			return NULL;
+	}
+}
+
+/// browse \a folder and return the name and inferred asyn parameter type of each shared variable in it 
+void NetShrVarInterface::browseParamGroup(const std::string& folder, std::vector< std::pair<std::string,std::string> >& vars)
+{
+#ifdef _WIN32
+	CNVBrowser browser = NULL;
+	char* item = NULL;
+	int leaf, error;
+	CNVBrowseType browseType = CNVBrowseTypeUndefined;
+	error = CNVCreateBrowser(&browser);
+	ERROR_CHECK("CNVCreateBrowser", error);
+	error = CNVBrowse(browser, folder.c_str());
+	if (error < 0)
+	{
+		CNVDisposeBrowser(browser);
+	    ERROR_CHECK("CNVBrowse", error);
+	}
+	while(true)
+	{
+		ScopedCNVData typeData;
+	    error = CNVBrowseNextItem(browser, &item, &leaf, &browseType, &typeData);
+		if (error <= 0 || item == NULL)
+		{
+			break;
+		}
+		std::string path(item), name;
+		CNVFreeMemory(item);
+		item = NULL;
+		if (browseType != CNVBrowseTypeItem)
+		{
+			continue;
+		}
+		size_t pos = path.rfind('\\');
+		name = (pos != std::string::npos ? path.substr(pos + 1) : path);
+		CNVDataType type = CNVEmpty;
+		unsigned int nDims = 0;
+		const char* param_type = NULL;
+		if (typeData != 0 && CNVGetDataType(typeData, &type, &nDims) >= 0)
+		{
+			param_type = inferParamType(type, nDims);
+		}
+		if (param_type != NULL)
+		{
+			vars.push_back(std::pair<std::string,std::string>(name, param_type));
+		}
+		else
+		{
+			std::cerr << "browseParamGroup: cannot infer parameter type for \"" << path << "\", ignoring" << std::endl;
+		}
+	}
+	CNVDisposeBrowser(browser);
+#else
+	std::cerr << "browseParamGroup: browsing \"" << folder << "\" is not supported on this platform" << std::endl;
+#endif
+}
+
+/// Create parameters for each  <paramgroup>  in our section by browsing for shared variables, or reading a previous browse 
+/// result from the group's cache file. The cache holds all variables found, so it stays valid if the pattern is changed; 
+/// delete it to browse again.
+void NetShrVarInterface::expandParamGroups()
+{
+	if (m_groups_expanded)
+	{
+		return;
+	}
+	m_groups_expanded = true;
+	m_group_params.clear();
+	const NvSectionGroupConfig* groups = m_config->sectionGroups(m_configSection);
+	if (groups == NULL)
+	{
+		return;
+	}
+	for(NvSectionGroupConfig::const_iterator it = groups->begin(); it != groups->end(); ++it)
+	{
+		const NvParamGroupConfig& gc = *it;
+		char* str = envExpand(gc.netvar.c_str());
+		std::string folder = (str != NULL ? str : "");
+		free(str);
+		str = envExpand(gc.cache.c_str());
+		std::string cache_file = (str != NULL ? str : "");
+		free(str);
+		std::replace(folder.begin(), folder.end(), '/', '\\');
+		if (folder.size() > 0 && folder[folder.size() - 1] == '\\')
+		{
+			folder.erase(folder.size() - 1);
+		}
+		std::vector< std::pair<std::string,std::string> > vars;
+		std::string header = "# NetShrVar browse cache for " + folder;
+		bool cached = false;
+		if (cache_file.size() > 0)
+		{
+			std::ifstream ifs(cache_file.c_str());
+			std::string line;
+			if (std::getline(ifs, line) && line == header)
+			{
+				// one variable per line as  name<TAB>type  as variable names may contain spaces
+				cached = true;
+				while(std::getline(ifs, line))
+				{
+					size_t tab = line.rfind('\t');
+					if (tab == std::string::npos || tab == 0 || tab + 1 == line.size())
+					{
+						std::cerr << "expandParamGroups: invalid line \"" << line << "\" in \"" << cache_file << "\", browsing again" << std::endl;
+						vars.clear();
+						cached = false;
+						break;
+					}
+					vars.push_back(std::pair<std::string,std::string>(line.substr(0, tab), line.substr(tab + 1)));
+				}
+			}
+			if (cached)
+			{
+				std::cerr << "expandParamGroups: read " << vars.size() << " variables for \"" << folder << "\" from \"" << cache_file << "\"" << std::endl;
+			}
+		}
+		if (!cached)
+		{
+			try
+			{
+			    browseParamGroup(folder, vars);
+			}
+			catch(const std::exception& ex)
+			{
+				std::cerr << "expandParamGroups: cannot browse \"" << folder << "\": " << ex.what() << std::endl;
+				continue;
+			}
+			std::cerr << "expandParamGroups: found " << vars.size() << " variables in \"" << folder << "\"" << std::endl;
+			if (cache_file.size() > 0)
+			{
+				std::ofstream ofs(cache_file.c_str());
+				ofs << header << "\n";
+				for(size_t i=0; i<vars.size(); ++i)
+				{
+					ofs << vars[i].first << '\t' << vars[i].second << "\n";
+				}
+				if (!ofs)
+				{
+					std::cerr << "expandParamGroups: unable to write browse cache \"" << cache_file << "\"" << std::endl;
+				}
+			}
+		}
+		for(size_t i=0; i<vars.size(); ++i)
+		{
+			if (!epicsStrGlobMatch(vars[i].first.c_str(), gc.pattern.c_str()))
+			{
+				continue;
+			}
+			NvParamConfig pc;
+			pc.name = gc.prefix + vars[i].first;
+			pc.type = (gc.type.size() > 0 ? gc.type : vars[i].second);
+			pc.netvar = folder + "\\" + vars[i].first;
+			pc.access = gc.access;
+			pc.max_rate = gc.max_rate;
+			m_group_params.push_back(pc);
+		}
+	}
+}
+
+void NetShrVarInterface::initAsynParamIds()
+{
+    static const char* functionName = "initAsynParamIds";
+	for(params_t::iterator it=m_params.begin(); it != m_params.end(); ++it)
+	{
+		NvItem* item = it->second;
+		if (item->id != -1)
+		{
+			continue; // already initialised
+		}
+		if (item->type == "float64" || item->type == "float32" || item->type == "ftimestamp")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamFloat64, &(item->id));
+		}
+		else if (item->type == "int32" || item->type == "boolean")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamInt32, &(item->id));
+		}
+		else if (item->type == "string" || item->type == "timestamp")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamOctet, &(item->id));
+		}
+		else if (item->type == "float64array")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamFloat64Array, &(item->id));
+		}
+		else if (item->type == "float32array")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamFloat32Array, &(item->id));
+		}
+		else if (item->type == "int32array")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamInt32Array, &(item->id));
+		}
+		else if (item->type == "int16array")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamInt16Array, &(item->id));
+		}
+		else if (item->type == "int8array" || item->type == "longstring")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamInt8Array, &(item->id));
+		}
+		else if (item->type == "int64" || item->type == "uint64")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamInt64, &(item->id));
+		}
+		else if (item->type == "int64array" || item->type == "uint64array")
+		{
+			m_driver->createParam(it->first.c_str(), asynParamInt64Array, &(item->id));
+		}
+		else
+		{
+			errlogSevPrintf(errlogMajor, "%s:%s: unknown type %s for parameter %s\n", driverName, 
+			                functionName, item->type.c_str(), it->first.c_str());
+		}
+		if (!item->derived && item->cb_data == NULL)
+		{
+			item->cb_data = new CallbackData(this, item->nv_name, item->id, item);
+		}
+	}
+}
+
+void NetShrVarInterface::createParams(asynPortDriver* driver)
+{
+    static const char* functionName = "createParams";
+    m_driver = driver;
+	getParams(m_params);
+	connectVars();
+}
+
+/// do the derived parameters that \a item (from a reloaded XML file, with parameter names \a new_names) refers to 
+/// already exist, called with #m_params_lock held
+bool NetShrVarInterface::derivedParamsExist(const NvItem* item, const std::map<const NvItem*, std::string>& new_names)
+{
+	std::vector<const NvItem*> refs(item->stats.items.begin(), item->stats.items.end());
+	const NvItem* others[] = { item->stats.preview_item, item->latency.net_item, item->latency.pub_item, item->shape.dims_item, item->shape.ndims_item, item->alarm.parent };
+	refs.insert(refs.end(), others, others + sizeof(others) / sizeof(others[0]));
+	for(size_t i=0; i<refs.size(); ++i)
+	{
+		std::map<const NvItem*, std::string>::const_iterator it = (refs[i] != NULL ? new_names.find(refs[i]) : new_names.end());
+		if (refs[i] != NULL && (it == new_names.end() || m_params.find(it->second) == m_params.end()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// is the configuration of two parameters, as read from the XML file, the same
+static bool sameConfig(const NvItem* lhs, const NvItem* rhs)
+{
+	return lhs->nv_name == rhs->nv_name && lhs->type == rhs->type && lhs->access == rhs->access && lhs->field == rhs->field &&
+		lhs->ts_param == rhs->ts_param && lhs->with_ts == rhs->with_ts && lhs->ts_source == rhs->ts_source && 
+		(lhs->host_clock == NULL) == (rhs->host_clock == NULL) && lhs->rate.max_rate == rhs->rate.max_rate && lhs->shape.transpose == rhs->shape.transpose &&
+		lhs->alarm.fields == rhs->alarm.fields && lhs->alarm.connected == rhs->alarm.connected && lhs->write_through.enabled == rhs->write_through.enabled && lhs->sr.max_age == rhs->sr.max_age && lhs->sr.poll_ms == rhs->sr.poll_ms &&
+		lhs->stats.items.size() == rhs->stats.items.size() && lhs->stats.preview_size == rhs->stats.preview_size && 
+		(lhs->shape.dims_item == NULL) == (rhs->shape.dims_item == NULL) && (lhs->latency.net_item == NULL) == (rhs->latency.net_item == NULL);
+}
+
+/// Re-read the XML file and apply any changes to our parameters. Parameters whose settings have changed are disconnected
+/// and reconnected, and parameters no longer in the file are disconnected and marked as #NvItem::removed. Records 
+/// bind to their parameters at iocInit, so a parameter that is new in the file (or a change that needs new derived 
+/// parameters e.g. adding stats) could not be used by any record and is ignored with a message that a restart is needed.
+/// asyn parameters cannot be deleted or change type, so a removed parameter stays in the parameter list (and is reused 
+/// if it is added back) and a change of type is rejected. Callbacks for other parameters carry on while we do this, so 
+/// an existing item is only changed once it has been disconnected and any update for it already queued has been 
+/// processed, and then with both the driver lock and #m_params_lock held.
+void NetShrVarInterface::reloadConfig()
+{
+	m_config = loadConfigFile(m_configFile, true);
+	m_groups_expanded = false;
+	browse_cache.clear();
+	std::cerr << "Reloaded XML config file \"" << m_configFile << "\"" << std::endl;
+	params_t new_params, alarm_params;
+	getParams(new_params);
+	// alarm field discovery may need to browse, so is done before taking any locks. Alarm parameters are then
+	// compared like any other, so those of a parameter that is removed and later added back are reconnected
+	for(params_t::const_iterator it=new_params.begin(); it != new_params.end(); ++it)
+	{
+		addAlarmParams(it->first, it->second, alarm_params);
+	}
+	new_params.insert(alarm_params.begin(), alarm_params.end());
+	std::map<const NvItem*, std::string> new_names;  // so we can find the name of a derived parameter
+	for(params_t::const_iterator it=new_params.begin(); it != new_params.end(); ++it)
+	{
+		new_names[it->second] = it->first;
+	}
+	std::vector<NvItem*> to_connect;
+	std::vector<NvItem*> to_disconnect;
+	std::vector<NvItem*> to_delete;
+	std::vector<NvItem*> removed;
+	std::vector<NvItem*> restored;  // derived parameters of a parameter that was removed and is now back
+	std::vector< std::pair<NvItem*,const NvItem*> > changed;  // existing item and its new settings
+	int n_new = 0, n_changed = 0, n_removed = 0;
+	// work out what has changed, existing items are left alone until they have been disconnected
+	m_params_lock.lock();
+	for(params_t::iterator it=new_params.begin(); it != new_params.end(); ++it)
+	{
+		NvItem* item = it->second;
+		to_delete.push_back(item);
+		params_t::iterator old_it = m_params.find(it->first);
+		if (old_it == m_params.end())
+		{
+			std::cerr << "reloadConfig: parameter \"" << it->first << "\" is new, records can only use it after a restart, ignoring" << std::endl;
+			++n_new;
+			continue;
+		}
+		NvItem* old_item = old_it->second;
+		if (old_item->type != item->type)
+		{
+			std::cerr << "reloadConfig: cannot change type of parameter \"" << it->first << "\" from " << old_item->type << " to " << item->type << 
+			    " without a restart, ignoring" << std::endl;
+			continue;
+		}
+		if (item->derived)
+		{
+			if (old_item->removed)   // was previously removed, now back
+			{
+				restored.push_back(old_item);
+			}
+			continue;
+		}
+		if (!old_item->removed && sameConfig(old_item, item))
+		{
+			continue;
+		}
+		if (!derivedParamsExist(item, new_names))
+		{
+			std::cerr << "reloadConfig: parameter \"" << it->first << "\" now needs derived parameters that do not exist, this needs a restart, ignoring" << std::endl;
+			continue;
+		}
+		std::cerr << "reloadConfig: parameter \"" << it->first << "\" has " << (old_item->removed ? "been added back" : "changed") << std::endl;
+		changed.push_back(std::pair<NvItem*,const NvItem*>(old_item, item));
+		if (!old_item->removed)
+		{
+			to_disconnect.push_back(old_item);
+		}
+		to_connect.push_back(old_item);
+		++n_changed;
+	}
+	// parameters no longer in the file, including any alarm parameters created for them. Sub array parameters
+	// are left for records to use if their array is added back 
+	for(params_t::iterator it=m_params.begin(); it != m_params.end(); ++it)
+	{
+		NvItem* item = it->second;
+		if (new_params.find(it->first) != new_params.end() || item->sub.kind != NvItem::NotSubArray || item->removed)
+		{
+			continue;
+		}
+		std::cerr << "reloadConfig: parameter \"" << it->first << "\" has been removed" << std::endl;
+		removed.push_back(item);
+		if (!item->derived)
+		{
+			to_disconnect.push_back(item);
+		}
+		++n_removed;
+	}
+	m_params_lock.unlock();
+	// connecting and disconnecting can take some time, so do not hold the driver lock while doing it 
+	for(size_t i=0; i<to_disconnect.size(); ++i)
+	{
+		disconnectItem(to_disconnect[i]);
+	}
+	if (m_dispatcher != NULL)
 	{
-		throw std::runtime_error("Cannot create mac handle");
+		m_dispatcher->flush();
 	}
-	for(char** cp = environ; *cp != NULL; ++cp)
+	m_driver->lock();
+	m_params_lock.lock();
+	for(size_t i=0; i<changed.size(); ++i)
 	{
-		char* str_tmp = strdup(*cp);
-		char* equals_loc = strchr(str_tmp, '='); // split   name=value   string
-		if (equals_loc != NULL)
+		NvItem* old_item = changed[i].first;
+		const NvItem* item = changed[i].second;
+		old_item->removed = false;
+		old_item->nv_name = item->nv_name;
+		old_item->access = item->access;
+		old_item->field = item->field;
+		old_item->ts_param = item->ts_param;
+		old_item->with_ts = item->with_ts;
+		old_item->ts_source = item->ts_source;
+		old_item->host_clock = item->host_clock;
+		old_item->alarm.connected = item->alarm.connected;
+		old_item->rate.max_rate = item->rate.max_rate;
+		old_item->sr.max_age = item->sr.max_age;
+		old_item->write_through.enabled = item->write_through.enabled;
+		old_item->write_through.echoes_pending.clear();
+		if (old_item->sr.poll_ms != item->sr.poll_ms)
+		{
+			old_item->sr.poll_ms = item->sr.poll_ms;
+			memset(&(old_item->sr.next_poll), 0, sizeof(old_item->sr.next_poll)); // so it is rescheduled
+		}
+		old_item->shape.transpose = item->shape.transpose;
+		old_item->stats.preview_size = item->stats.preview_size;
+		if (old_item->cb_data != NULL && old_item->cb_data->nv_name != old_item->nv_name)
 		{
-		    *equals_loc = '\0';
-		    macPutValue(m_mac_env, str_tmp, equals_loc + 1);
+			// nothing refers to the old one now we are disconnected and the dispatcher has been flushed 
+			delete old_item->cb_data;
+			old_item->cb_data = new CallbackData(this, old_item->nv_name, old_item->id, old_item);
 		}
-		free(str_tmp);
+		// pointers to other parameters need to refer to the items in m_params rather than new_params 
+		std::vector<NvItem*> stats_items;
+		for(size_t j=0; j<item->stats.items.size(); ++j)
+		{
+			stats_items.push_back(m_params[new_names[item->stats.items[j]]]);
+		}
+		old_item->stats.items.swap(stats_items);
+		old_item->stats.preview_item = (item->stats.preview_item != NULL ? m_params[new_names[item->stats.preview_item]] : NULL);
+		old_item->latency.net_item = (item->latency.net_item != NULL ? m_params[new_names[item->latency.net_item]] : NULL);
+		old_item->latency.pub_item = (item->latency.pub_item != NULL ? m_params[new_names[item->latency.pub_item]] : NULL);
+		old_item->shape.dims_item = (item->shape.dims_item != NULL ? m_params[new_names[item->shape.dims_item]] : NULL);
+		old_item->shape.ndims_item = (item->shape.ndims_item != NULL ? m_params[new_names[item->shape.ndims_item]] : NULL);
+		old_item->alarm.parent = (item->alarm.parent != NULL ? m_params[new_names[item->alarm.parent]] : NULL);
 	}
-	char* configFile_expanded = envExpand(configFile);
-	m_configFile = configFile_expanded;
-	epicsAtExit(epicsExitFunc, this);
-
-    pugi::xml_parse_result result = m_xmlconfig.load_file(configFile_expanded);
-	free(configFile_expanded);
-	if (result)
+	for(size_t i=0; i<restored.size(); ++i)
 	{
-	    std::cerr << "Loaded XML config file \"" << m_configFile << "\" (expanded from \"" << configFile << "\")" << std::endl;
+		restored[i]->removed = false;
 	}
-    else
-    {
-		throw std::runtime_error("Cannot load XML \"" + m_configFile + "\" (expanded from \"" + std::string(configFile) + "\"): load failure: "
-		    + result.description());
-    }
+	for(size_t i=0; i<removed.size(); ++i)
+	{
+		removed[i]->removed = true;
+	}
+	m_params_lock.unlock();
+	for(size_t i=0; i<restored.size(); ++i)
+	{
+		setParamStatus(restored[i]->id, asynSuccess);
+	}
+	for(size_t i=0; i<removed.size(); ++i)
+	{
+		setParamStatus(removed[i]->id, asynDisconnected, epicsAlarmComm, epicsSevInvalid);
+		for(size_t j=0; j<removed[i]->sub.items.size(); ++j)
+		{
+			setParamStatus(removed[i]->sub.items[j]->id, asynDisconnected, epicsAlarmComm, epicsSevInvalid);
+		}
+	}
+	m_driver->unlock();
+	for(size_t i=0; i<to_connect.size(); ++i)
+	{
+		setParamStatus(to_connect[i]->id, asynSuccess);
+		connectItem(to_connect[i]);
+	}
+	m_driver->lock();
+	m_driver->callParamCallbacks();
+	m_driver->unlock();
+	for(size_t i=0; i<to_delete.size(); ++i)
+	{
+		delete to_delete[i];
+	}
+	startSingleReadPolling();
+	std::cerr << "reloadConfig: " << n_changed << " parameters changed, " << n_removed << " removed, " << n_new << " new ignored" << std::endl;
 }
 
-// need to be careful here as might get called at wrong point. May need to check with driver.
-void NetShrVarInterface::epicsExitFunc(void* arg)
+/// the item for asyn parameter \a param_name. This takes #m_params_lock so can be used from NI callback threads while
+/// reloadConfig() or createSubArrayParam() are adding parameters, the item itself stays valid as items are never removed 
+NvItem* NetShrVarInterface::findItem(const std::string& param_name)
 {
-//	NetShrVarInterface* netvarint = static_cast<NetShrVarInterface*>(arg);
-//	if (netvarint == NULL)
-//	{
-//		return;
-//	}
-//	if ( netvarint->checkOption(Something) )
-//	{
-//	}
-    CNVFinish();
+	epicsGuard<epicsMutex> _lock(m_params_lock);
+	params_t::const_iterator it = m_params.find(param_name);
+	if (it == m_params.end())
+	{
+		throw std::runtime_error("unknown parameter \"" + param_name + "\"");
+	}
+	return it->second;
 }
 
-size_t NetShrVarInterface::nParams()
+/// the item for asyn parameter \a param_name as for findItem(), for a record reading or writing it. Fails if the 
+/// parameter has been removed from the XML file, as it is no longer connected to its network shared variable
+NvItem* NetShrVarInterface::findActiveItem(const char* param_name)
 {
-	char control_name_xpath[MAX_PATH_LEN];
-	epicsSnprintf(control_name_xpath, sizeof(control_name_xpath), "/netvar/section[@name='%s']/param", m_configSection.c_str());
-	try
+	NvItem* item = findItem(param_name);
+	if (item->removed)
 	{
-        pugi::xpath_node_set params = m_xmlconfig.select_nodes(control_name_xpath);
-        return params.size();
+		throw std::runtime_error(std::string("parameter \"") + param_name + "\" has been removed from the XML file");
 	}
-	catch(const std::exception& ex)
+	return item;
+}
+
+/// the current entries of #m_params, for looping over them without the driver lock held. These stay valid
+/// while parameters are added as a std::map does not move its entries and we never remove any
+void NetShrVarInterface::paramEntries(std::vector<const params_t::value_type*>& entries)
+{
+	epicsGuard<epicsMutex> _lock(m_params_lock);
+	entries.clear();
+	entries.reserve(m_params.size());
+	for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
 	{
-	    std::cerr << "nparams failed " << ex.what() << std::endl;
-	    return 0;
+		entries.push_back(&(*it));
 	}
 }
 
-void NetShrVarInterface::initAsynParamIds()
+/// create items for the parameters in our section of the configuration file (see loadConfigFile()) and add them to \a params
+void NetShrVarInterface::getParams(params_t& params)
 {
-    static const char* functionName = "initAsynParamIds";
-	for(params_t::iterator it=m_params.begin(); it != m_params.end(); ++it)
+	params.clear();
+	const NvSectionConfig* section = m_config->section(m_configSection);
+	const NvSectionGroupConfig* groups = m_config->sectionGroups(m_configSection);
+	if ((section == NULL || section->size() == 0) && groups == NULL)
 	{
-		NvItem* item = it->second;
-		if (item->id != -1)
-		{
-			continue; // already initialised
-		}
-		if (item->type == "float64" || item->type == "ftimestamp")
-		{
-			m_driver->createParam(it->first.c_str(), asynParamFloat64, &(item->id));
-		}
-		else if (item->type == "int32" || item->type == "boolean")
-		{
-			m_driver->createParam(it->first.c_str(), asynParamInt32, &(item->id));
-		}
-		else if (item->type == "string" || item->type == "timestamp")
+	    std::cerr << "getParams failed: no parameters in section \"" << m_configSection << "\"" << std::endl;
+	    return;
+	}
+	if (section != NULL)
+	{
+		for (NvSectionConfig::const_iterator it = section->begin(); it != section->end(); ++it)
 		{
-			m_driver->createParam(it->first.c_str(), asynParamOctet, &(item->id));
+			addParam(params, *it);
 		}
-		else if (item->type == "float64array")
+	}
+	expandParamGroups();
+	for (std::vector<NvParamConfig>::const_iterator it = m_group_params.begin(); it != m_group_params.end(); ++it)
+	{
+		if (params.find(it->name) == params.end())  // an explicit  <param>  takes precedence
 		{
-			m_driver->createParam(it->first.c_str(), asynParamFloat64Array, &(item->id));
+		    addParam(params, *it);
 		}
-		else if (item->type == "float32array")
+	}
+}
+
+/// create an item for a parameter from the configuration file and add it to \a params
+void NetShrVarInterface::addParam(params_t& params, const NvParamConfig& pc)
+{
+	std::string ts_param = pc.ts_param;
+	char* netvar = envExpand(pc.netvar.c_str());
+	std::string nv_name = (netvar != NULL ? netvar : "");
+	free(netvar);
+	if (ts_param.size() > 0 && params.find(ts_param) == params.end())
+	{
+		std::cerr << "getParams: Unable to link unknown \"" << ts_param << "\" as ts_param for " << pc.name << std::endl;
+		ts_param = "";
+	}
+	if (pc.max_rate > 0.0 && !(pc.access & NvItem::Read))
+	{
+		std::cerr << "getParams: max_rate is only used with R access, ignoring for param " << pc.name << std::endl;
+	}
+	NvItem* item = new NvItem(nv_name, pc.type.c_str(), pc.access, pc.field, ts_param, pc.with_ts, pc.max_rate);
+	params[pc.name] = item;
+	item->shape.transpose = pc.transpose;
+	item->alarm.fields = pc.alarms;
+	item->sr.max_age = pc.max_age;
+	setTsSource(item, pc);
+	if (pc.write_through)
+	{
+		if (!(pc.access & (NvItem::Write | NvItem::BufferedWrite)))
 		{
-			m_driver->createParam(it->first.c_str(), asynParamFloat32Array, &(item->id));
+			std::cerr << "getParams: write_through is only used with W or BW access, ignoring for param " << pc.name << std::endl;
 		}
-		else if (item->type == "int32array")
+		else if (pc.type != "float64" && pc.type != "float32" && pc.type != "int32" && pc.type != "boolean" && pc.type != "int64" && pc.type != "uint64" && pc.type != "string")
 		{
-			m_driver->createParam(it->first.c_str(), asynParamInt32Array, &(item->id));
+			std::cerr << "getParams: write_through is only used with scalar and string types, ignoring for param " << pc.name << std::endl;
 		}
-		else if (item->type == "int16array")
+		else
 		{
-			m_driver->createParam(it->first.c_str(), asynParamInt16Array, &(item->id));
+			item->write_through.enabled = true;
 		}
-		else if (item->type == "int8array")
+	}
+	if (pc.max_age > 0.0 && !(pc.access & NvItem::SingleRead))
+	{
+		std::cerr << "getParams: max_age is only used with SR access, ignoring for param " << pc.name << std::endl;
+	}
+	if (pc.poll_ms > 0 && !(pc.access & NvItem::SingleRead))
+	{
+		std::cerr << "getParams: poll_ms is only used with SR access, ignoring for param " << pc.name << std::endl;
+	}
+	else
+	{
+		item->sr.poll_ms = pc.poll_ms;
+	}
+	if (pc.stats || pc.preview > 0 || pc.shape)
+	{
+		addDerivedArrayParams(params, pc.name, item, pc.stats, pc.preview, pc.shape);
+	}
+	if (pc.latency)
+	{
+		addLatencyParams(params, pc.name, item);
+	}
+}
+
+/// create the derived _LatNet and _LatPub latency parameters for parameter \a name and add them to \a params
+void NetShrVarInterface::addLatencyParams(params_t& params, const std::string& name, NvItem* item)
+{
+	if (!(item->access & NvItem::Read))
+	{
+		std::cerr << "getParams: latency is only measured with R access, ignoring for param " << name << std::endl;
+		return;
+	}
+	item->latency.net_item = new NvItem(item->nv_name, "float64", 0, -1, "", false);
+	item->latency.net_item->derived = true;
+	params[name + "_LatNet"] = item->latency.net_item;
+	item->latency.pub_item = new NvItem(item->nv_name, "float64", 0, -1, "", false);
+	item->latency.pub_item->derived = true;
+	params[name + "_LatPub"] = item->latency.pub_item;
+}
+
+/// decide where the timestamp of \a item comes from. Without an explicit ts_source this is ts_param if given, 
+/// then with_ts, then the server timestamp as before ts_source was added
+void NetShrVarInterface::setTsSource(NvItem* item, const NvParamConfig& pc)
+{
+	NvTsSource source = pc.ts_source;
+	if (source == NvTsDefault)
+	{
+		source = (item->ts_param.size() > 0 ? NvTsLinked : (item->with_ts ? NvTsEmbedded : NvTsServer));
+	}
+	if (source == NvTsLinked && item->ts_param.size() == 0)
+	{
+		std::cerr << "getParams: ts_source=\"linked\" needs a valid ts_param, using server timestamp for param " << pc.name << std::endl;
+		source = NvTsServer;
+	}
+	if (source != NvTsLinked && item->ts_param.size() > 0)
+	{
+		std::cerr << "getParams: ts_param is only used with ts_source=\"linked\", ignoring for param " << pc.name << std::endl;
+		item->ts_param = "";
+	}
+	if (source == NvTsEmbedded)
+	{
+		item->with_ts = true;
+	}
+	item->ts_source = source;
+	if (pc.correct_clock)
+	{
+		if (source == NvTsServer)
 		{
-			m_driver->createParam(it->first.c_str(), asynParamInt8Array, &(item->id));
+			item->host_clock = HostClock::forHost(item->nv_name);
 		}
 		else
 		{
-			errlogSevPrintf(errlogMajor, "%s:%s: unknown type %s for parameter %s\n", driverName, 
-			                functionName, item->type.c_str(), it->first.c_str());
+			std::cerr << "getParams: correct_clock is only used with server timestamps, ignoring for param " << pc.name << std::endl;
 		}
 	}
 }
 
-void NetShrVarInterface::createParams(asynPortDriver* driver)
+/// create the derived statistics, preview and shape parameters requested for array parameter \a name and add them to \a params
+void NetShrVarInterface::addDerivedArrayParams(params_t& params, const std::string& name, NvItem* item, bool with_stats, int preview_size, bool with_shape)
 {
-    static const char* functionName = "createParams";
-    m_driver = driver;
-	getParams();
-	connectVars();
+	if (item->type.size() < 5 || item->type.substr(item->type.size() - 5) != "array")
+	{
+		std::cerr << "getParams: stats, preview and shape are only used for array types, ignoring for param " << name << std::endl;
+		return;
+	}
+	if (with_shape)
+	{
+		item->shape.dims_item = new NvItem(item->nv_name, "int32array", 0, -1, "", false);
+		item->shape.dims_item->derived = true;
+		params[name + "_Dims"] = item->shape.dims_item;
+		item->shape.ndims_item = new NvItem(item->nv_name, "int32", 0, -1, "", false);
+		item->shape.ndims_item->derived = true;
+		params[name + "_NDims"] = item->shape.ndims_item;
+	}
+	if (with_stats)
+	{
+		for(int i=0; i<ArrayStats::NStats; ++i)
+		{
+			NvItem* stats_item = new NvItem(item->nv_name, "float64", 0, -1, "", false);
+			stats_item->derived = true;
+			item->stats.items.push_back(stats_item);
+			params[name + "_" + ArrayStats::name(i)] = stats_item;
+		}
+	}
+	if (preview_size > 0)
+	{
+		item->stats.preview_item = new NvItem(item->nv_name, "float64array", 0, -1, "", false);
+		item->stats.preview_item->derived = true;
+		item->stats.preview_size = preview_size;
+		params[name + "_Preview"] = item->stats.preview_item;
+	}
 }
 
-void NetShrVarInterface::getParams()
+/// Create a parameter referring to part of an existing array parameter. This is called from NetShrVarDriver::drvUserCreate()
+/// when a record specifies an unknown parameter name of the form  name[index]  for a single element,
+/// name[start:length]  for a slice, or  name[row:index]  or  name[col:index]  for a row or column of a two
+/// dimensional array. An element is a float64 (or int32 for an integer array) parameter, the others 
+/// are array parameters of the same type as the original. Only the referenced elements are copied on each update.
+/// This happens at iocInit after connectVars() has started the subscribers, see #m_params for the locking needed.
+/// \return true if the parameter was created, false if \a param is not a sub array reference
+bool NetShrVarInterface::createSubArrayParam(const char* param)
 {
-	m_params.clear();
-	char control_name_xpath[MAX_PATH_LEN];
-	epicsSnprintf(control_name_xpath, sizeof(control_name_xpath), "/netvar/section[@name='%s']/param", m_configSection.c_str());
-    pugi::xpath_node_set params;
-	try
+	std::string name(param);
+	size_t lbracket = name.rfind('[');
+	if (lbracket == std::string::npos || lbracket == 0 || name[name.size() - 1] != ']')
 	{
-	    params = m_xmlconfig.select_nodes(control_name_xpath);
-	    if (params.size() == 0)
-	    {
-	        std::cerr << "getParams failed" << std::endl;
-		    return;
-	    }
+		return false;
 	}
-	catch(const std::exception& ex)
+	std::string array_name = name.substr(0, lbracket);
+	std::string index_str = name.substr(lbracket + 1, name.size() - lbracket - 2);
+	NvItem::SubArrayKind sub_kind = NvItem::SubElement;
+	if (index_str.compare(0, 4, "row:") == 0)
 	{
-	    std::cerr << "getParams failed " << ex.what() << std::endl;
-		return;
+		sub_kind = NvItem::SubRow;
+		index_str.erase(0, 4);
 	}
-	int field;
-	unsigned access_mode;
-	char *last_str = NULL;
-	char *access_str, *str;
-	for (pugi::xpath_node_set::const_iterator it = params.begin(); it != params.end(); ++it)
-	{
-		pugi::xpath_node node = *it;	
-		std::string attr1 = node.node().attribute("name").value();
-		std::string attr2 = node.node().attribute("type").value();
-		std::string attr3 = node.node().attribute("access").value();
-		std::string attr4 = envExpand(node.node().attribute("netvar").value());
-		std::string attr5 = node.node().attribute("field").value();	
-		std::string attr6 = node.node().attribute("ts_param").value();
-		std::string with_ts_s = node.node().attribute("with_ts").value();
-        bool with_ts = false;
-        if (with_ts_s == "true")
-        {
-            with_ts = true;
-        }
-		if (attr5.size() == 0)
+	else if (index_str.compare(0, 4, "col:") == 0)
+	{
+		sub_kind = NvItem::SubColumn;
+		index_str.erase(0, 4);
+	}
+	else if (index_str.find(':') != std::string::npos)
+	{
+		sub_kind = NvItem::SubSlice;
+	}
+	bool element = (sub_kind == NvItem::SubElement);
+	unsigned long start = 0, len = 1;
+	char* endp = NULL;
+	start = strtoul(index_str.c_str(), &endp, 10);
+	if (endp == index_str.c_str() || (sub_kind != NvItem::SubSlice && *endp != '\0') || (sub_kind == NvItem::SubSlice && *endp != ':'))
+	{
+		throw std::runtime_error("createSubArrayParam: cannot parse index in \"" + name + "\"");
+	}
+	if (sub_kind == NvItem::SubSlice)
+	{
+		const char* len_str = endp + 1;
+		len = strtoul(len_str, &endp, 10);
+		if (endp == len_str || *endp != '\0' || len == 0)
 		{
-			field = -1;
+			throw std::runtime_error("createSubArrayParam: cannot parse slice length in \"" + name + "\"");
 		}
-		else
+	}
+	m_driver->lock();
+	params_t::iterator it = m_params.find(array_name);
+	if (it == m_params.end() || it->second->type.size() < 5 || it->second->type.substr(it->second->type.size() - 5) != "array")
+	{
+		m_driver->unlock();
+		throw std::runtime_error("createSubArrayParam: \"" + array_name + "\" is not an array parameter");
+	}
+	NvItem* item = it->second;
+	const char* sub_type = item->type.c_str();
+	if (element)
+	{
+		if (item->type.compare(0, 5, "float") == 0)
 		{
-			field = atoi(attr5.c_str());
+			sub_type = "float64";
 		}
-		access_str = strdup(attr3.c_str());
-		access_mode = 0;
-		str = epicsStrtok_r(access_str, ",", &last_str);
-		while( str != NULL )
+		else if (item->type == "int64array" || item->type == "uint64array")
 		{
-			if (!strcmp(str, "R"))
-			{
-				access_mode |= NvItem::Read;
-			}
-			else if (!strcmp(str, "BR"))
-			{
-				access_mode |= NvItem::BufferedRead;
-			}
-			else if (!strcmp(str, "SR"))
-			{
-				access_mode |= NvItem::SingleRead;
-			}
-			else if (!strcmp(str, "W"))
-			{
-				access_mode |= NvItem::Write;
-			}
-			else if (!strcmp(str, "BW"))
-			{
-				access_mode |= NvItem::BufferedWrite;
-			}
-			else
-			{
-				std::cerr << "getParams: Unknown access mode \"" << str << "\" for param " << attr1 << std::endl;
-			}
-			str = epicsStrtok_r(NULL, ",", &last_str);
+			sub_type = "int64";
 		}
-		free(access_str);
-		if (attr6.size() > 0 && m_params.find(attr6) == m_params.end())
+		else
 		{
-			std::cerr << "getParams: Unable to link unknown \"" << attr6 << "\" as ts_param for " << attr1 << std::endl;
-			attr6 = "";
+			sub_type = "int32";
 		}
-		m_params[attr1] = new NvItem(attr4.c_str(),attr2.c_str(),access_mode,field,attr6,with_ts);
-	}	
+	}
+	NvItem* sub_item = new NvItem(item->nv_name, sub_type, 0, -1, "", false);
+	sub_item->derived = true;
+	sub_item->auto_created = true;
+	sub_item->sub.kind = sub_kind;
+	sub_item->sub.start = start;
+	sub_item->sub.len = len;
+	// subscribers are already running, so we need m_params_lock as well as the driver lock to add to m_params. 
+	// NvItem::SubArray::items is only used with the driver locked
+	m_params_lock.lock();
+	m_params.insert(params_t::value_type(name, sub_item));
+	m_params_lock.unlock();
+	item->sub.items.push_back(sub_item);
+	initAsynParamIds();
+	updateSubArraysFromCache(item);
+	m_driver->unlock();
+	return true;
 }
 
 template <>
 void NetShrVarInterface::setValue(const char* param, const std::string& value)
 {
     ScopedCNVData cvalue;
+	NvItem* item = findActiveItem(param);
 	int status = CNVCreateScalarDataValue(&cvalue, CNVString, value.c_str());
 	ERROR_CHECK("CNVCreateScalarDataValue", status);
-	setValueCNV(param, cvalue);
+	if (item->write_through.enabled)
+	{
+		item->write_through.value.svalue = value;
+	}
+	writeThrough(param, item, std::move(cvalue));
+	item->string_value = value;  // the driver also sets the asyn parameter to the value written
+	if (item->type == "longstring")
+	{
+		// a longstring is read back as a char array, so keep array_data in step (with a terminating NULL as updateLongStringValue())
+		item->array_data.assign(value.c_str(), value.c_str() + value.size() + 1);
+	}
+}
+
+/// Copy the current value of string parameter \a paramName into \a value, without padding. Called with m_driver locked.
+/// \param[out] value buffer of size \a maxChars, NULL terminated if there is room
+/// \param[out] nActual number of characters copied
+/// \param[out] nAvailable length of the complete string, more than \a nActual if it was truncated
+void NetShrVarInterface::readStringValue(const char* paramName, char* value, size_t maxChars, size_t* nActual, size_t* nAvailable)
+{
+	const std::string& string_value = findActiveItem(paramName)->string_value;
+	size_t n = std::min(string_value.size(), maxChars);
+	memcpy(value, string_value.data(), n);
+	if (n < maxChars)
+	{
+		value[n] = '\0';
+	}
+	*nActual = n;
+	*nAvailable = string_value.size();
+}
+
+/// the configured type (e.g. "uint64") of parameter \a paramName, called with m_driver locked
+std::string NetShrVarInterface::paramType(const char* paramName)
+{
+	return findItem(paramName)->type;
 }
 
 template <typename T>
 void NetShrVarInterface::setValue(const char* param, const T& value)
 {
     ScopedCNVData cvalue;
+	NvItem* item = findActiveItem(param);
 	int status = CNVCreateScalarDataValue(&cvalue, static_cast<CNVDataType>(C2CNV<T>::nvtype), value);
 	ERROR_CHECK("CNVCreateScalarDataValue", status);
-	setValueCNV(param, cvalue);
+	if (item->write_through.enabled)
+	{
+		// a floating point value may be NaN or out of range for an integer, its echo is only compared as a double
+		item->write_through.value.value = static_cast<double>(value);
+		item->write_through.value.ivalue = (std::numeric_limits<T>::is_integer ? static_cast<epicsInt64>(value) : 0);
+	}
+	writeThrough(param, item, std::move(cvalue));
+}
+
+/// write a scalar \a value to parameter \a param, called with m_driver locked. For a #NvItem::WriteThrough parameter 
+/// the write time becomes the parameter timestamp, so is used when the driver then sets the parameter to the value
+/// written, and the subscriber update echoing our write is expected. The value written must already be recorded in \a item.
+void NetShrVarInterface::writeThrough(const char* param, NvItem* item, ScopedCNVData value)
+{
+	if (!item->write_through.enabled)
+	{
+		setValueCNV(param, std::move(value));
+		return;
+	}
+	epicsTimeGetCurrent(&(item->write_through.last_write));
+	if (item->access & NvItem::Read)
+	{
+		if (item->write_through.echoes_pending.size() >= 100)  // echoes are not arriving, so do not keep growing
+		{
+			item->write_through.echoes_pending.pop_front();
+		}
+		item->write_through.echoes_pending.push_back(item->write_through.value);  // before writing, as the echo may arrive while the driver is unlocked 
+	}
+	try
+	{
+		setValueCNV(param, std::move(value));
+	}
+	catch(...)
+	{
+		item->write_through.echoes_pending.clear();
+		throw;
+	}
+	item->epicsTS = item->write_through.last_write;
+	m_driver->setTimeStamp(&(item->epicsTS));
+	if (item->access & NvItem::SingleRead)
+	{
+		item->sr.last_read = item->write_through.last_write;  // so a read within max_age uses the value we wrote
+	}
 }
 
+/// called with m_driver locked. For a whole (not structure field) array shared variable the CNVData from the 
+/// previous write is reused if the size and type are the same, so we only copy \a value rather than allocate each time
 template <typename T>
 void NetShrVarInterface::setArrayValue(const char* param, const T* value, size_t nElements)
 {
-    ScopedCNVData cvalue;
+	NvItem* item = findActiveItem(param);
+	CNVDataType type = static_cast<CNVDataType>(C2CNV<T>::nvtype);
 	size_t dimensions[1] = { nElements };
-    int status = CNVCreateArrayDataValue(&cvalue, static_cast<CNVDataType>(C2CNV<T>::nvtype), value, 1, dimensions);
-	ERROR_CHECK("CNVCreateArrayDataValue", status);
-	setValueCNV(param, cvalue);
+	int status;
+	if (item->type == "longstring")
+	{
+		if (sizeof(T) != 1)
+		{
+			throw std::runtime_error("setArrayValue: longstring param \""  + std::string(param) + "\" can only be written as a char array");
+		}
+		// the record may not include a terminating NULL, and the string stops at the first one if it does
+		const char* cvalue = reinterpret_cast<const char*>(value);
+		setValue(param, std::string(cvalue, std::find(cvalue, cvalue + nElements, '\0')));
+		return;
+	}
+	if (item->field != -1 || item->write_buf.busy)
+	{
+        ScopedCNVData cvalue;
+        status = CNVCreateArrayDataValue(&cvalue, type, value, 1, dimensions);
+	    ERROR_CHECK("CNVCreateArrayDataValue", status);
+	    setValueCNV(param, std::move(cvalue));
+		return;
+	}
+	if (item->write_buf.data != 0 && item->write_buf.type == type && item->write_buf.elements == nElements)
+	{
+	    status = CNVSetArrayDataValue(item->write_buf.data, type, value, 1, dimensions);
+	    ERROR_CHECK("CNVSetArrayDataValue", status);
+	}
+	else
+	{
+	    status = CNVCreateArrayDataValue(&(item->write_buf.data), type, value, 1, dimensions);
+	    ERROR_CHECK("CNVCreateArrayDataValue", status);
+	    item->write_buf.type = type;
+	    item->write_buf.elements = nElements;
+	}
+	// the driver lock is released during the write, so mark write_buf as in use
+	item->write_buf.busy = true;
+	try
+	{
+	    writeValueCNV(param, item, item->write_buf.data);
+	}
+	catch(...)
+	{
+		item->write_buf.busy = false;
+		throw;
+	}
+	item->write_buf.busy = false;
 }
 
-void NetShrVarInterface::setValueCNV(const std::string& name, CNVData value)
+/// write \a value to the shared variable for parameter \a name, we take ownership of \a value
+void NetShrVarInterface::setValueCNV(const std::string& name, ScopedCNVData value)
 {
-	NvItem* item = m_params[name];
+	NvItem* item = findItem(name);
 	int error = 0;
 	ScopedCNVData cvalue;
 	if (item->field != -1)
@@ -1431,13 +3921,13 @@ void NetShrVarInterface::setValueCNV(const std::string& name, CNVData value)
             error = CNVSetStructDataValue(cvalue, fields, numberOfFields);
             ERROR_CHECK("CNVSetStructDataValue", error);
             for(int i=0; i<numberOfFields; ++i) {
-                if (i != field) { // value will be freed by caller as scoped data
+                if (i != field) { // value is still owned by us
                     error = CNVDisposeData(fields[i]);
                     ERROR_CHECK("CNVDisposeData", error);
                 }
             }
             delete[] fields;
-            value = cvalue;
+            value = std::move(cvalue); // the structure copied our field, so dispose of it and write the whole structure
         }
         else
         {
@@ -1445,6 +3935,14 @@ void NetShrVarInterface::setValueCNV(const std::string& name, CNVData value)
             return;
         }
 	}
+	writeValueCNV(name, item, value);
+}
+
+/// write \a value to the shared variable of \a item using its writer or buffered writer, the caller keeps ownership of \a value. 
+/// Called with m_driver locked, but this is released during the write
+void NetShrVarInterface::writeValueCNV(const std::string& name, NvItem* item, CNVData value)
+{
+	int error = 0;
 	if (item->access & NvItem::Write)
 	{
 		m_driver->unlock(); // to allow DataCallback to work while we try and write
@@ -1489,9 +3987,19 @@ void NetShrVarInterface::updateValues()
     CNVBufferDataStatus dataStatus;
 	int status;
     static int netshrvar_simulate = getenv("NETSHRVAR_SIMULATE") != NULL ? atoi(getenv("NETSHRVAR_SIMULATE")) : 0;
-	for(params_t::const_iterator it=m_params.begin(); it != m_params.end(); ++it)
+	std::vector<const params_t::value_type*> entries;
+	paramEntries(entries);
+	for(std::vector<const params_t::value_type*>::const_iterator it=entries.begin(); it != entries.end(); ++it)
 	{
-		const NvItem* item = it->second;
+		NvItem* item = (*it)->second;
+		if (item->removed)
+		{
+			continue;
+		}
+		if (item->rate.max_rate > 0.0)
+		{
+			processDeferredUpdate(item);
+		}
 		if (netshrvar_simulate || item->access & NvItem::Read)
 		{
 		    ;  // we are a subscriber so automatically get updates on changes
@@ -1499,9 +4007,14 @@ void NetShrVarInterface::updateValues()
 		else if (item->access & NvItem::BufferedRead)
 		{
 			ScopedCNVData value;
+			if (!item->conn.lock.tryLock())
+			{
+				continue;  // being connected or disconnected, so try again next time
+			}
 			if (item->b_subscriber != NULL)
 			{
 				status = CNVGetDataFromBuffer(item->b_subscriber, &value, &dataStatus);
+				item->conn.lock.unlock();
 				if (status < 0)
 				{
 	                std::cerr << NetShrVarException::ni_message("CNVGetDataFromBuffer", status);
@@ -1509,7 +4022,7 @@ void NetShrVarInterface::updateValues()
 				}
 				if (dataStatus == CNVDataWasLost)
 				{
-					std::cerr << "NetShrVarInterface::updateValues: BufferedReader: data was lost for param \"" << it->first << "\" (" << item->nv_name << ") - is poll frequency too low?" << std::endl;
+					std::cerr << "NetShrVarInterface::updateValues: BufferedReader: data was lost for param \"" << (*it)->first << "\" (" << item->nv_name << ") - is poll frequency too low?" << std::endl;
 					// set an alarm status?
 				}
 				if (dataStatus == CNVNewData || dataStatus == CNVDataWasLost)  // returns CNVStaleData if value unchanged frm last read
@@ -1519,7 +4032,8 @@ void NetShrVarInterface::updateValues()
 			}
 			else
 			{
-				std::cerr << "NetShrVarInterface::updateValues: BufferedReader: param \"" << it->first << "\" (" << item->nv_name << ") is not valid" << std::endl;
+				item->conn.lock.unlock();
+				std::cerr << "NetShrVarInterface::updateValues: BufferedReader: param \"" << (*it)->first << "\" (" << item->nv_name << ") is not valid" << std::endl;
 			}
 		}
 		else
@@ -1552,10 +4066,15 @@ void NetShrVarInterface::report(FILE* fp, int details)
     last_items_read = m_items_read;
     last_bytes_read = m_bytes_read;
     m_last_report = now;
-	for(params_t::iterator it=m_params.begin(); it != m_params.end(); ++it)
+	if (m_dispatcher != NULL)
 	{
-		NvItem* item = it->second;
-		item->report(it->first, fp);
+		m_dispatcher->report(fp);
+	}
+	std::vector<const params_t::value_type*> entries;
+	paramEntries(entries);
+	for(std::vector<const params_t::value_type*>::const_iterator it=entries.begin(); it != entries.end(); ++it)
+	{
+		(*it)->second->report((*it)->first, fp);
 	}
 }
 
@@ -1563,6 +4082,9 @@ void NetShrVarInterface::report(FILE* fp, int details)
 
 template void NetShrVarInterface::setValue(const char* param, const double& value);
 template void NetShrVarInterface::setValue(const char* param, const int& value);
+template void NetShrVarInterface::setValue(const char* param, const float& value);
+template void NetShrVarInterface::setValue(const char* param, const __int64& value);
+template void NetShrVarInterface::setValue(const char* param, const unsigned __int64& value);
 
 template void NetShrVarInterface::setArrayValue(const char* param, const double* value, size_t nElements);
 template void NetShrVarInterface::setArrayValue(const char* param, const float* value, size_t nElements);
@@ -1570,6 +4092,8 @@ template void NetShrVarInterface::setArrayValue(const char* param, const int* va
 template void NetShrVarInterface::setArrayValue(const char* param, const short* value, size_t nElements);
 template void NetShrVarInterface::setArrayValue(const char* param, const char* value, size_t nElements);
 template void NetShrVarInterface::setArrayValue(const char* param, const signed char* value, size_t nElements);
+template void NetShrVarInterface::setArrayValue(const char* param, const __int64* value, size_t nElements);
+template void NetShrVarInterface::setArrayValue(const char* param, const unsigned __int64* value, size_t nElements);
 
 template void NetShrVarInterface::readArrayValue(const char* paramName, double* value, size_t nElements, size_t* nIn);
 template void NetShrVarInterface::readArrayValue(const char* paramName, float* value, size_t nElements, size_t* nIn);
@@ -1577,5 +4101,6 @@ template void NetShrVarInterface::readArrayValue(const char* paramName, int* val
 template void NetShrVarInterface::readArrayValue(const char* paramName, short* value, size_t nElements, size_t* nIn);
 template void NetShrVarInterface::readArrayValue(const char* paramName, char* value, size_t nElements, size_t* nIn);
 template void NetShrVarInterface::readArrayValue(const char* paramName, signed char* value, size_t nElements, size_t* nIn);
+template void NetShrVarInterface::readArrayValue(const char* paramName, epicsInt64* value, size_t nElements, size_t* nIn);
 
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
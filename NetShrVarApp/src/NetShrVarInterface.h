@@ -29,6 +29,7 @@
 #include <fstream>
 #include <iostream>
 #include <cstdint>
+#include <memory>
 
 #if defined(_WIN32) && defined(_MSC_VER) && _MSC_VER < 1700 /* Pre VS2012 */
 // boost atomic is not header only, volatile should be enough here
@@ -43,6 +44,7 @@ typedef std::atomic<uint64_t> my_atomic_uint64_t;
 #endif
 
 #include <epicsMutex.h>
+#include <epicsEvent.h>
 #include <epicsThread.h>
 #include <epicsExit.h>
 #include <macLib.h>
@@ -53,6 +55,7 @@ typedef std::atomic<uint64_t> my_atomic_uint64_t;
 #include <cvinetv.h>
 
 #include "pugixml.hpp"
+#include "configcache.h"
 
 #ifdef NetShrVarSymbols
 #undef NetShrVarSymbols
@@ -60,12 +63,21 @@ typedef std::atomic<uint64_t> my_atomic_uint64_t;
 #include <shareLib.h>
 #endif
 
-/// option argument in NetShrVarConfigure() of @link st.cmd @endlink not used at present
-enum NetShrVarOptions { NVNothing = 0, NVSomething=1 };
+/// option argument in NetShrVarConfigure() of @link st.cmd @endlink, values can be combined
+enum NetShrVarOptions { 
+	NVNothing = 0, 
+	NVSomething=1, 
+	NVDispatchThreads=2,   ///< process subscriber updates on a pool of worker threads, see #NvDispatcher
+	NVPublisherThread=4,   ///< process subscriber updates on a single thread rather than the NI callback thread, ignored if #NVDispatchThreads given
+	NVDropNewest=8         ///< with #NVDispatchThreads or #NVPublisherThread, keep the update already waiting for a variable rather than replacing it with a newer one
+};
 
 struct NvItem;
 class asynPortDriver;
 struct CallbackData;
+struct ArrayStats;
+class ScopedCNVData;
+class NvDispatcher;
 
 
 /// Manager class for the NetVar Interaction. Parses an @link netvarconfig.xml @endlink file and provides access to the 9variables described within. 
@@ -74,17 +86,23 @@ class epicsShareClass NetShrVarInterface
 public:
 	NetShrVarInterface(const char* configSection, const char *configFile, int options);
 	size_t nParams();
-	~NetShrVarInterface() { }
+	~NetShrVarInterface();
 	void updateValues();
 	void createParams(asynPortDriver* driver);
 	void report(FILE* fp, int details);
 	void readValue(const char* param);
+	void readStringValue(const char* paramName, char* value, size_t maxChars, size_t* nActual, size_t* nAvailable);
+	std::string paramType(const char* paramName);
 	void dataTransferredCallback (void * handle, int error, CallbackData* cb_data);
 	void dataCallback (void * handle, CNVData data, CallbackData* cb_data);
+	void processDataCallback (CNVData data, CallbackData* cb_data, epicsUInt64 t_receive);
+	void updateLatency(NvItem* item, CNVData data, epicsUInt64 t_receive);
 	void statusCallback (void * handle, CNVConnectionStatus status, int error, CallbackData* cb_data);
 	template<typename T> void setValue(const char* param, const T& value);
 	template<typename T> void setArrayValue(const char* param, const T* value, size_t nElements);
 	template<typename T> void readArrayValue(const char* paramName, T* value, size_t nElements, size_t* nIn);
+	bool createSubArrayParam(const char* param);
+	void reloadConfig();
 	static bool varExists(const std::string& path);
 	static bool pathExists(const std::string& path);
   
@@ -95,11 +113,32 @@ private:
 //	epicsMutex m_lock;
 	asynPortDriver* m_driver;
 	typedef std::map<std::string,NvItem*> params_t;
-	params_t m_params;
-	pugi::xml_document m_xmlconfig;
-    MAC_HANDLE* m_mac_env;
+	params_t m_params; ///< only changed with both the driver locked and #m_params_lock held, so either is enough to read it. Items are never removed
+	epicsMutex m_params_lock; ///< protects #m_params (and the settings of its items) for threads not holding the driver lock, see findItem()
+	std::shared_ptr<const NvConfigFile> m_config; ///< parsed contents of \a m_configFile, shared with other instances using the same file
+	std::vector<NvParamConfig> m_group_params; ///< parameters created from the  <paramgroup>  elements of our section
+	bool m_groups_expanded; ///< have we browsed for the  <paramgroup>  parameters yet
+    std::shared_ptr<NvEnvSnapshot> m_env; ///< environment when we were created, for macro expansion in the XML file
 	int m_writer_wait_ms; ///< how long to wait for a write operation to complete in milliseconds
 	int m_b_writer_wait_ms; ///< how long to wait for a buffered write operation to complete in milliseconds
+	NvDispatcher* m_dispatcher; ///< worker threads for subscriber updates if #NVDispatchThreads or #NVPublisherThread option given, otherwise NULL
+	/// one of our background threads, which sleep on #wake so stopThreads() need not wait for a sleep to finish
+	struct ThreadControl
+	{
+		bool started; ///< has the thread been created
+		epicsEvent wake; ///< signalled by stopThreads() to end the thread's current sleep
+		epicsEvent done; ///< signalled by the thread when it exits
+		ThreadControl() : started(false) { }
+	};
+	ThreadControl m_sr_polling; ///< thread for single read parameters with a poll_ms attribute
+	std::string m_snapshot_file; ///< file parameter values are saved to and restored from, empty if not in use
+	double m_snapshot_period; ///< how often (seconds) #m_snapshot_file is written
+	ThreadControl m_snapshot_thread; ///< thread that writes #m_snapshot_file
+	ThreadControl m_health_monitor; ///< thread that retries failed connections
+	double m_reconnect_min; ///< delay (seconds) before the first retry of a failed connection
+	double m_reconnect_max; ///< maximum delay (seconds) between retries of a failed connection, 0 to not retry
+	std::vector<NvItem*> m_deferred_init; ///< items restored from #m_snapshot_file whose initial read is left to the snapshot thread
+	volatile bool m_shutting_down; ///< set by stopThreads() at IOC exit or when we are deleted, to stop our threads
     
     my_atomic_uint32_t m_items_read;
     my_atomic_uint64_t m_bytes_read;
@@ -118,24 +157,66 @@ private:
 	
     template<typename T> void getAsynParamValue(int param, T& value);
     char* envExpand(const char *str);
-	void getParams();
-	void setValueCNV(const std::string& name, CNVData value);
+	void getParams(params_t& params);
+	NvItem* findItem(const std::string& param_name);
+	void paramEntries(std::vector<const params_t::value_type*>& entries);
+	void addParam(params_t& params, const NvParamConfig& pc);
+	void expandParamGroups();
+	void browseParamGroup(const std::string& folder, std::vector< std::pair<std::string,std::string> >& vars);
+	void setValueCNV(const std::string& name, ScopedCNVData value);
+	void writeThrough(const char* param, NvItem* item, ScopedCNVData value);
+	void writeValueCNV(const std::string& name, NvItem* item, CNVData value);
 	static void epicsExitFunc(void* arg);
 	bool checkOption(NetShrVarOptions option) { return ( m_options & static_cast<int>(option) ) != 0; }
 	void connectVars();
+	void addAlarmParams(const std::string& param_name, NvItem* item, params_t& new_params);
+	bool connectItem(NvItem* item, bool retry = false);
+	bool connectFailed(NvItem* item, const char* func, int error);
+	void startHealthMonitor();
+	static void healthMonitorThread(void* arg);
+	bool derivedParamsExist(const NvItem* item, const std::map<const NvItem*, std::string>& new_names);
+	NvItem* findActiveItem(const char* param_name);
+	void stopThreads();
+	void healthMonitor();
+	void disconnectItem(NvItem* item);
     bool convertTimeStamp(unsigned __int64 timestamp, epicsTimeStamp *epicsTS);
 	template<typename T> void updateParamValue(int param_index, T val, epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks);
-	template<typename T> void updateParamArrayValue(int param_index, T* val, size_t nElements,
+	template<typename T> bool isWriteEcho(NvItem* item, T val);
+	template<typename T> void updateParamArrayValue(int param_index, T* val, size_t nElements, const size_t* dims, unsigned nDims,
                                                             epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks);
 	void updateParamCNV (int param_index, CNVData data, epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks);
 	template<CNVDataType cnvType> void updateParamCNVImpl(int param_index, CNVData data, CNVDataType type, 
                                        unsigned int nDims, epicsTimeStamp* epicsTS, bool do_asyn_param_callbacks);
-	template<typename T,typename U> void updateParamArrayValueImpl(int param_index, T* val, size_t nElements);
+	template<typename T,typename U> void updateParamArrayValueImpl(int param_index, NvItem* item, T* val, size_t nElements, 
+	                                       epicsTimeStamp* epicsTS, std::vector<size_t>& new_dims);
+	template<typename T> bool computeArrayStats(bool with_stats, size_t preview_size, const T* val, size_t nElements, ArrayStats& stats, std::vector<epicsFloat64>& preview);
+	void updateArrayStats(NvItem* item, bool stats_valid, const ArrayStats& stats, const std::vector<epicsFloat64>& preview);
+	template<typename U> void updateSubArrays(NvItem* item, U* val, size_t nElements);
+	void updateSubArraysFromCache(NvItem* item);
+	void setTsSource(NvItem* item, const NvParamConfig& pc);
+	void addLatencyParams(params_t& params, const std::string& name, NvItem* item);
+	void addDerivedArrayParams(params_t& params, const std::string& name, NvItem* item, bool with_stats, int preview_size, bool with_shape);
+	void updateArrayShape(NvItem* item);
+	void updateLongStringValue(int param_index, NvItem* item, const char* val);
+	void publishRestoredArray(NvItem* item, const std::string& value);
+	template<typename U> void publishRestoredArrayImpl(NvItem* item, const std::string& value);
 	void readVarInit(NvItem* item);
+	void initialRead(NvItem* item);
+	void singleRead(const char* paramName, NvItem* item, bool is_array);
+	void startSingleReadPolling();
+	static void singleReadPollThread(void* arg);
+	void pollSingleReads();
+	void startSnapshots();
+	static void snapshotThread(void* arg);
+	void snapshotLoop();
+	void writeSnapshot();
+	void restoreSnapshot();
     void setParamStatus(int param_id, asynStatus status, epicsAlarmCondition alarmStat = epicsAlarmNone, epicsAlarmSeverity alarmSevr = epicsSevNone);
 	void getParamStatus(int param_id, asynStatus& status, int& alarmStat, int& alarmSevr);
     void initAsynParamIds();
-	void updateConnectedAlarmStatus(const std::string& paramName, int value, const std::string& alarmStr, epicsAlarmCondition stat, epicsAlarmSeverity sevr);
+	void updateConnectedAlarmStatus(const NvItem* alarm_item, int value);
+	bool deferUpdate(NvItem* item, ScopedCNVData& data);
+	void processDeferredUpdate(NvItem* item);
 };
 
 #endif /* NETSHRVAR_INTERFACE_H */
@@ -0,0 +1,249 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file arrayconvert.cpp Array element type conversion, vectorised with SSE2 or AVX2 where available.
+/// The instruction set is chosen at compile time: AVX2 kernels are only used if the compiler is targeting AVX2 
+/// (e.g. /arch:AVX2 or -mavx2), otherwise SSE2 which all x64 processors support.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#define NSV_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NSV_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "arrayconvert.h"
+
+/// scalar loop for elements \a i to \a n, used for what is left over after a vectorised loop
+template<typename T, typename U>
+static inline void convertTail(const T* in, U* out, size_t i, size_t n)
+{
+	for(; i<n; ++i)
+	{
+		out[i] = static_cast<U>(in[i]);
+	}
+}
+
+template<>
+bool convertArray(const double* in, float* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2)
+	for(; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+	}
+#elif defined(NSV_USE_SSE2)
+	for(; i + 4 <= n; i += 4)
+	{
+		__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+		__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+		_mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+template<>
+bool convertArray(const float* in, double* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2)
+	for(; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+	}
+#elif defined(NSV_USE_SSE2)
+	for(; i + 4 <= n; i += 4)
+	{
+		__m128 f = _mm_loadu_ps(in + i);
+		_mm_storeu_pd(out + i, _mm_cvtps_pd(f));
+		_mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+/// truncates towards zero like static_cast, out of range values give INT_MIN rather than being undefined
+template<>
+bool convertArray(const double* in, int* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2)
+	for(; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvttpd_epi32(_mm256_loadu_pd(in + i)));
+	}
+#elif defined(NSV_USE_SSE2)
+	for(; i + 4 <= n; i += 4)
+	{
+		__m128i lo = _mm_cvttpd_epi32(_mm_loadu_pd(in + i));
+		__m128i hi = _mm_cvttpd_epi32(_mm_loadu_pd(in + i + 2));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi64(lo, hi));
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+template<>
+bool convertArray(const int* in, double* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2)
+	for(; i + 4 <= n; i += 4)
+	{
+		_mm256_storeu_pd(out + i, _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+	}
+#elif defined(NSV_USE_SSE2)
+	for(; i + 4 <= n; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		_mm_storeu_pd(out + i, _mm_cvtepi32_pd(v));
+		_mm_storeu_pd(out + i + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))));
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+template<>
+bool convertArray(const int* in, float* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2)
+	for(; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))));
+	}
+#elif defined(NSV_USE_SSE2)
+	for(; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+#if defined(NSV_USE_SSE2)
+/// widen eight 16 bit integers to two registers of four 32 bit integers, sign or zero extending
+static inline void widen16(__m128i v, bool is_signed, __m128i& lo, __m128i& hi)
+{
+	if (is_signed)
+	{
+		lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+	}
+	else
+	{
+		__m128i zero = _mm_setzero_si128();
+		lo = _mm_unpacklo_epi16(v, zero);
+		hi = _mm_unpackhi_epi16(v, zero);
+	}
+}
+
+/// SSE2 conversion of eight 16 bit integers to double
+static inline void convert16ToDouble(const void* in, double* out, bool is_signed)
+{
+	__m128i lo, hi;
+	widen16(_mm_loadu_si128(static_cast<const __m128i*>(in)), is_signed, lo, hi);
+	_mm_storeu_pd(out, _mm_cvtepi32_pd(lo));
+	_mm_storeu_pd(out + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2))));
+	_mm_storeu_pd(out + 4, _mm_cvtepi32_pd(hi));
+	_mm_storeu_pd(out + 6, _mm_cvtepi32_pd(_mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+/// SSE2 conversion of eight 16 bit integers to float
+static inline void convert16ToFloat(const void* in, float* out, bool is_signed)
+{
+	__m128i lo, hi;
+	widen16(_mm_loadu_si128(static_cast<const __m128i*>(in)), is_signed, lo, hi);
+	_mm_storeu_ps(out, _mm_cvtepi32_ps(lo));
+	_mm_storeu_ps(out + 4, _mm_cvtepi32_ps(hi));
+}
+#endif /* NSV_USE_SSE2 */
+
+#if defined(NSV_USE_AVX2)
+/// AVX2 conversion of eight 16 bit integers to double
+static inline void convert16ToDouble(const void* in, double* out, bool is_signed)
+{
+	__m128i v = _mm_loadu_si128(static_cast<const __m128i*>(in));
+	__m256i w = (is_signed ? _mm256_cvtepi16_epi32(v) : _mm256_cvtepu16_epi32(v));
+	_mm256_storeu_pd(out, _mm256_cvtepi32_pd(_mm256_castsi256_si128(w)));
+	_mm256_storeu_pd(out + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(w, 1)));
+}
+
+/// AVX2 conversion of eight 16 bit integers to float
+static inline void convert16ToFloat(const void* in, float* out, bool is_signed)
+{
+	__m128i v = _mm_loadu_si128(static_cast<const __m128i*>(in));
+	_mm256_storeu_ps(out, _mm256_cvtepi32_ps(is_signed ? _mm256_cvtepi16_epi32(v) : _mm256_cvtepu16_epi32(v)));
+}
+#endif /* NSV_USE_AVX2 */
+
+template<>
+bool convertArray(const short* in, double* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2) || defined(NSV_USE_SSE2)
+	for(; i + 8 <= n; i += 8)
+	{
+		convert16ToDouble(in + i, out + i, true);
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+template<>
+bool convertArray(const short* in, float* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2) || defined(NSV_USE_SSE2)
+	for(; i + 8 <= n; i += 8)
+	{
+		convert16ToFloat(in + i, out + i, true);
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+template<>
+bool convertArray(const unsigned short* in, double* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2) || defined(NSV_USE_SSE2)
+	for(; i + 8 <= n; i += 8)
+	{
+		convert16ToDouble(in + i, out + i, false);
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
+
+template<>
+bool convertArray(const unsigned short* in, float* out, size_t n)
+{
+	size_t i = 0;
+#if defined(NSV_USE_AVX2) || defined(NSV_USE_SSE2)
+	for(; i + 8 <= n; i += 8)
+	{
+		convert16ToFloat(in + i, out + i, false);
+	}
+#endif
+	convertTail(in, out, i, n);
+	return true;
+}
@@ -0,0 +1,45 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file arrayconvert.h Header for element type conversion of arrays, used when a shared variable array type differs from the asyn parameter type.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#ifndef ARRAYCONVERT_H
+#define ARRAYCONVERT_H
+
+#include <cstddef>
+
+/// Convert \a n elements of \a in to type U in \a out using the usual C++ numeric conversion rules.
+/// Generic version, vectorised specialisations exist for the common float/double/int16/int32 combinations
+template<typename T, typename U>
+bool convertArray(const T* in, U* out, size_t n)
+{
+	for(size_t i=0; i<n; ++i)
+	{
+		out[i] = static_cast<U>(in[i]);
+	}
+	return true;
+}
+
+/// arrays of strings cannot be converted to numeric types
+template<typename T, typename U>
+bool convertArray(T* const* in, U* out, size_t n)
+{
+	return false;
+}
+
+template<> bool convertArray(const double* in, float* out, size_t n);
+template<> bool convertArray(const float* in, double* out, size_t n);
+template<> bool convertArray(const double* in, int* out, size_t n);
+template<> bool convertArray(const int* in, double* out, size_t n);
+template<> bool convertArray(const int* in, float* out, size_t n);
+template<> bool convertArray(const short* in, double* out, size_t n);
+template<> bool convertArray(const short* in, float* out, size_t n);
+template<> bool convertArray(const unsigned short* in, double* out, size_t n);
+template<> bool convertArray(const unsigned short* in, float* out, size_t n);
+
+#endif /* ARRAYCONVERT_H */
@@ -0,0 +1,219 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file arraystats.cpp Array statistics and decimation routines, vectorised with SSE2 where available.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#include <cstddef>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NSV_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "arraystats.h"
+
+const char* ArrayStats::name(int i)
+{
+	static const char* names[NStats] = { "Min", "Max", "Mean", "Sum", "RMS" };
+	return (i >= 0 && i < NStats ? names[i] : "");
+}
+
+#ifdef NSV_USE_SSE2
+
+/// horizontal sum of the two doubles in an SSE register
+static inline double hsum_pd(__m128d v)
+{
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+/// SSE2 version, processes four doubles per loop using two sets of accumulators
+template<>
+bool computeArrayStats(const double* data, size_t n, ArrayStats& stats)
+{
+	stats = ArrayStats();
+	if (n == 0)
+	{
+		return true;
+	}
+	__m128d vmin0 = _mm_set1_pd(data[0]), vmax0 = vmin0, vmin1 = vmin0, vmax1 = vmin0;
+	__m128d sum0 = _mm_setzero_pd(), sum1 = sum0, sumsq0 = sum0, sumsq1 = sum0;
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+	{
+		__m128d a = _mm_loadu_pd(data + i);
+		__m128d b = _mm_loadu_pd(data + i + 2);
+		vmin0 = _mm_min_pd(vmin0, a);
+		vmax0 = _mm_max_pd(vmax0, a);
+		vmin1 = _mm_min_pd(vmin1, b);
+		vmax1 = _mm_max_pd(vmax1, b);
+		sum0 = _mm_add_pd(sum0, a);
+		sum1 = _mm_add_pd(sum1, b);
+		sumsq0 = _mm_add_pd(sumsq0, _mm_mul_pd(a, a));
+		sumsq1 = _mm_add_pd(sumsq1, _mm_mul_pd(b, b));
+	}
+	vmin0 = _mm_min_pd(vmin0, vmin1);
+	vmax0 = _mm_max_pd(vmax0, vmax1);
+	vmin0 = _mm_min_sd(vmin0, _mm_unpackhi_pd(vmin0, vmin0));
+	vmax0 = _mm_max_sd(vmax0, _mm_unpackhi_pd(vmax0, vmax0));
+	double vmin = _mm_cvtsd_f64(vmin0), vmax = _mm_cvtsd_f64(vmax0);
+	double sum = hsum_pd(_mm_add_pd(sum0, sum1)), sumsq = hsum_pd(_mm_add_pd(sumsq0, sumsq1));
+	for(; i<n; ++i)
+	{
+		double v = data[i];
+		if (v < vmin)
+		{
+			vmin = v;
+		}
+		if (v > vmax)
+		{
+			vmax = v;
+		}
+		sum += v;
+		sumsq += v * v;
+	}
+	stats.min = vmin;
+	stats.max = vmax;
+	stats.sum = sum;
+	stats.sumsq = sumsq;
+	stats.n = n;
+	return true;
+}
+
+/// SSE2 version, floats are widened to double two at a time so accumulation is done in double precision
+template<>
+bool computeArrayStats(const float* data, size_t n, ArrayStats& stats)
+{
+	stats = ArrayStats();
+	if (n == 0)
+	{
+		return true;
+	}
+	__m128d vmin0 = _mm_set1_pd(data[0]), vmax0 = vmin0;
+	__m128d sum0 = _mm_setzero_pd(), sumsq0 = sum0;
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+	{
+		__m128 f = _mm_loadu_ps(data + i);
+		__m128d a = _mm_cvtps_pd(f);
+		__m128d b = _mm_cvtps_pd(_mm_movehl_ps(f, f));
+		vmin0 = _mm_min_pd(vmin0, _mm_min_pd(a, b));
+		vmax0 = _mm_max_pd(vmax0, _mm_max_pd(a, b));
+		sum0 = _mm_add_pd(sum0, _mm_add_pd(a, b));
+		sumsq0 = _mm_add_pd(sumsq0, _mm_add_pd(_mm_mul_pd(a, a), _mm_mul_pd(b, b)));
+	}
+	vmin0 = _mm_min_sd(vmin0, _mm_unpackhi_pd(vmin0, vmin0));
+	vmax0 = _mm_max_sd(vmax0, _mm_unpackhi_pd(vmax0, vmax0));
+	double vmin = _mm_cvtsd_f64(vmin0), vmax = _mm_cvtsd_f64(vmax0);
+	double sum = hsum_pd(sum0), sumsq = hsum_pd(sumsq0);
+	for(; i<n; ++i)
+	{
+		double v = data[i];
+		if (v < vmin)
+		{
+			vmin = v;
+		}
+		if (v > vmax)
+		{
+			vmax = v;
+		}
+		sum += v;
+		sumsq += v * v;
+	}
+	stats.min = vmin;
+	stats.max = vmax;
+	stats.sum = sum;
+	stats.sumsq = sumsq;
+	stats.n = n;
+	return true;
+}
+
+template<>
+double arraySum(const double* data, size_t n)
+{
+	__m128d sum0 = _mm_setzero_pd(), sum1 = sum0;
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+	{
+		sum0 = _mm_add_pd(sum0, _mm_loadu_pd(data + i));
+		sum1 = _mm_add_pd(sum1, _mm_loadu_pd(data + i + 2));
+	}
+	double sum = hsum_pd(_mm_add_pd(sum0, sum1));
+	for(; i<n; ++i)
+	{
+		sum += data[i];
+	}
+	return sum;
+}
+
+#else
+
+// no SSE2, use plain loops but still with multiple accumulators so the compiler can pipeline them
+
+template<>
+bool computeArrayStats(const double* data, size_t n, ArrayStats& stats)
+{
+	stats = ArrayStats();
+	if (n == 0)
+	{
+		return true;
+	}
+	double vmin = data[0], vmax = vmin, sum[2] = { 0.0, 0.0 }, sumsq[2] = { 0.0, 0.0 };
+	size_t i = 0;
+	for(; i + 2 <= n; i += 2)
+	{
+		double a = data[i], b = data[i + 1];
+		vmin = (a < vmin ? a : vmin);
+		vmax = (a > vmax ? a : vmax);
+		vmin = (b < vmin ? b : vmin);
+		vmax = (b > vmax ? b : vmax);
+		sum[0] += a;
+		sum[1] += b;
+		sumsq[0] += a * a;
+		sumsq[1] += b * b;
+	}
+	for(; i<n; ++i)
+	{
+		double v = data[i];
+		vmin = (v < vmin ? v : vmin);
+		vmax = (v > vmax ? v : vmax);
+		sum[0] += v;
+		sumsq[0] += v * v;
+	}
+	stats.min = vmin;
+	stats.max = vmax;
+	stats.sum = sum[0] + sum[1];
+	stats.sumsq = sumsq[0] + sumsq[1];
+	stats.n = n;
+	return true;
+}
+
+template<>
+bool computeArrayStats(const float* data, size_t n, ArrayStats& stats)
+{
+	return computeArrayStatsGeneric(data, n, stats);
+}
+
+template<>
+double arraySum(const double* data, size_t n)
+{
+	double sum[2] = { 0.0, 0.0 };
+	size_t i = 0;
+	for(; i + 2 <= n; i += 2)
+	{
+		sum[0] += data[i];
+		sum[1] += data[i + 1];
+	}
+	for(; i<n; ++i)
+	{
+		sum[0] += data[i];
+	}
+	return sum[0] + sum[1];
+}
+
+#endif /* NSV_USE_SSE2 */
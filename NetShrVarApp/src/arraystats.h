@@ -0,0 +1,139 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file arraystats.h Header for array statistics and decimation routines used for derived array parameters.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#ifndef ARRAYSTATS_H
+#define ARRAYSTATS_H
+
+#include <cstddef>
+#include <cmath>
+
+/// summary statistics of an array, see computeArrayStats()
+struct ArrayStats
+{
+	enum { Min=0, Max, Mean, Sum, RMS, NStats };   ///< index of each statistic as returned by value()
+	double min;
+	double max;
+	double sum;
+	double sumsq;   ///< sum of squares
+	size_t n;   ///< number of elements
+	ArrayStats() : min(0.0), max(0.0), sum(0.0), sumsq(0.0), n(0) { }
+	double value(int i) const
+	{
+		switch(i)
+		{
+			case Min:
+				return min;
+			case Max:
+				return max;
+			case Mean:
+				return (n > 0 ? sum / n : 0.0);
+			case Sum:
+				return sum;
+			case RMS:
+				return (n > 0 ? sqrt(sumsq / n) : 0.0);
+			default:
+				return 0.0;
+		}
+	}
+	static const char* name(int i);
+};
+
+/// compute summary statistics of an array with a simple loop
+template<typename T>
+bool computeArrayStatsGeneric(const T* data, size_t n, ArrayStats& stats)
+{
+	stats = ArrayStats();
+	if (n == 0)
+	{
+		return true;
+	}
+	double vmin = static_cast<double>(data[0]), vmax = vmin, sum = 0.0, sumsq = 0.0;
+	for(size_t i=0; i<n; ++i)
+	{
+		double v = static_cast<double>(data[i]);
+		if (v < vmin)
+		{
+			vmin = v;
+		}
+		if (v > vmax)
+		{
+			vmax = v;
+		}
+		sum += v;
+		sumsq += v * v;
+	}
+	stats.min = vmin;
+	stats.max = vmax;
+	stats.sum = sum;
+	stats.sumsq = sumsq;
+	stats.n = n;
+	return true;
+}
+
+/// compute summary statistics of an array. Generic version, faster specialisations exist for float and double
+template<typename T>
+bool computeArrayStats(const T* data, size_t n, ArrayStats& stats)
+{
+	return computeArrayStatsGeneric(data, n, stats);
+}
+
+/// statistics are not meaningful for arrays of strings
+template<typename T>
+bool computeArrayStats(T* const* data, size_t n, ArrayStats& stats)
+{
+	return false;
+}
+
+template<> bool computeArrayStats(const double* data, size_t n, ArrayStats& stats);
+template<> bool computeArrayStats(const float* data, size_t n, ArrayStats& stats);
+
+/// sum of an array. Generic version, a faster specialisation exists for double
+template<typename T>
+double arraySum(const T* data, size_t n)
+{
+	double sum = 0.0;
+	for(size_t i=0; i<n; ++i)
+	{
+		sum += static_cast<double>(data[i]);
+	}
+	return sum;
+}
+
+template<> double arraySum(const double* data, size_t n);
+
+/// Reduce an array of \a n elements to at most \a nout points, each output point being the mean of
+/// an equal sized block of input elements. Returns the number of points written to \a out
+template<typename T>
+size_t decimateArray(const T* data, size_t n, double* out, size_t nout)
+{
+	if (n <= nout)
+	{
+		for(size_t i=0; i<n; ++i)
+		{
+			out[i] = static_cast<double>(data[i]);
+		}
+		return n;
+	}
+	for(size_t i=0; i<nout; ++i)
+	{
+		size_t first = (i * n) / nout, last = ((i + 1) * n) / nout;
+		out[i] = arraySum(data + first, last - first) / (last - first);
+	}
+	return nout;
+}
+
+/// decimation is not meaningful for arrays of strings
+template<typename T>
+size_t decimateArray(T* const* data, size_t n, double* out, size_t nout)
+{
+	return 0;
+}
+
+#endif /* ARRAYSTATS_H */
@@ -57,3 +57,5 @@ asynStatus (asynPortDriver::*C2CNV<unsigned int>::asyn_callback)(int* value, siz
 asynStatus (asynPortDriver::*C2CNV<unsigned short>::asyn_callback)(short* value, size_t nElements, int reason, int addr) = &asynPortDriver::doCallbacksInt16Array;
 asynStatus (asynPortDriver::*C2CNV<unsigned char>::asyn_callback)(signed char* value, size_t nElements, int reason, int addr) = &asynPortDriver::doCallbacksInt8Array;
 asynStatus (asynPortDriver::*C2CNV<bool>::asyn_callback)(signed char* value, size_t nElements, int reason, int addr) = &asynPortDriver::doCallbacksInt8Array;
+asynStatus (asynPortDriver::*C2CNV<__int64>::asyn_callback)(epicsInt64* value, size_t nElements, int reason, int addr) = &asynPortDriver::doCallbacksInt64Array;
+asynStatus (asynPortDriver::*C2CNV<unsigned __int64>::asyn_callback)(epicsInt64* value, size_t nElements, int reason, int addr) = &asynPortDriver::doCallbacksInt64Array;
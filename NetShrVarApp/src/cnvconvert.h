@@ -230,7 +230,7 @@ struct C2CNV<__int64>
 {
     enum { nvtype = CNVInt64 };
 	static const char* desc;
-	static asynStatus (asynPortDriver::*asyn_callback)(__int64* value, size_t nElements, int reason, int addr);
+	static asynStatus (asynPortDriver::*asyn_callback)(epicsInt64* value, size_t nElements, int reason, int addr);
 };
 
 template<>
@@ -238,9 +238,18 @@ struct C2CNV<unsigned __int64>
 {
     enum { nvtype = CNVUInt64 };
 	static const char* desc;
-	static asynStatus (asynPortDriver::*asyn_callback)(__int64* value, size_t nElements, int reason, int addr);
+	static asynStatus (asynPortDriver::*asyn_callback)(epicsInt64* value, size_t nElements, int reason, int addr);
 };
 
+/// call an asyn array callback such as C2CNV::asyn_callback, the data pointer is cast to the type the callback expects
+/// as this may differ from our own type for equivalent data e.g.  __int64  and  epicsInt64 
+template<typename A>
+static asynStatus doAsynArrayCallback(asynPortDriver* driver, asynStatus (asynPortDriver::*callback)(A* value, size_t nElements, int reason, int addr),
+                                      void* value, size_t nElements, int reason)
+{
+	return (driver->*callback)(static_cast<A*>(value), nElements, reason, 0);
+}
+
 // type convertions - used when we set asyn parameters. We want to cast basic type -> basic type and pointer -> pointer, but ignore
 // everything else which shouldn't get called anyway.
 // e.g.    convertToScalar<double>(value)
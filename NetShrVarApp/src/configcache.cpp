@@ -0,0 +1,239 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file configcache.cpp Load @link netvarconfig.xml @endlink files in a single pass and cache the result, so several 
+/// NetShrVarConfigure() calls on the same file only parse it once. The environment snapshot used for macro expansion
+/// is shared in the same way.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif /* _WIN32 */
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <iostream>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include "pugixml.hpp"
+
+#include "configcache.h"
+
+/// Return a snapshot of the current process environment. If the environment has not changed since 
+/// the last call, and an earlier snapshot is still in use, that snapshot is returned rather than a new one being made.
+std::shared_ptr<NvEnvSnapshot> getEnvSnapshot()
+{
+	static std::weak_ptr<NvEnvSnapshot> last_env;
+	static unsigned long long last_hash = 0;
+	static epicsMutex env_lock;
+	epicsGuard<epicsMutex> _lock(env_lock);
+	// FNV-1a hash of environment strings, this is much cheaper than loading them all into a new macro handle
+	unsigned long long hash = 14695981039346656037ULL;
+	for(char** cp = environ; *cp != NULL; ++cp)
+	{
+		for(const unsigned char* p = reinterpret_cast<const unsigned char*>(*cp); *p != '\0'; ++p)
+		{
+			hash = (hash ^ *p) * 1099511628211ULL;
+		}
+		hash = (hash ^ '\n') * 1099511628211ULL;
+	}
+	std::shared_ptr<NvEnvSnapshot> env = last_env.lock();
+	if (env && hash == last_hash)
+	{
+		return env;
+	}
+	env.reset(new NvEnvSnapshot);
+	if (macCreateHandle(&(env->mac_env), NULL) != 0)
+	{
+		throw std::runtime_error("Cannot create mac handle");
+	}
+	for(char** cp = environ; *cp != NULL; ++cp)
+	{
+		const char* equals_loc = strchr(*cp, '='); // split   name=value   string
+		if (equals_loc != NULL)
+		{
+		    macPutValue(env->mac_env, std::string(*cp, equals_loc - *cp).c_str(), equals_loc + 1);
+		}
+	}
+	last_env = env;
+	last_hash = hash;
+	return env;
+}
+
+/// Parse a comma separated list of access modes e.g. "R,BW" into a combination of #NvAccessMode
+unsigned parseAccessMode(const char* access_str, const std::string& param_name)
+{
+	static const struct { const char* name; NvAccessMode mode; } modes[] = { 
+	    { "R", NvAccessRead }, { "BR", NvAccessBufferedRead }, { "SR", NvAccessSingleRead }, 
+	    { "W", NvAccessWrite }, { "BW", NvAccessBufferedWrite } };
+	unsigned access_mode = 0;
+	const char* str = access_str;
+	while(*str != '\0')
+	{
+		size_t len = strcspn(str, ",");
+		if (len > 0)
+		{
+			bool found = false;
+			for(size_t i=0; i<sizeof(modes) / sizeof(modes[0]) && !found; ++i)
+			{
+				if (strlen(modes[i].name) == len && strncmp(str, modes[i].name, len) == 0)
+				{
+					access_mode |= modes[i].mode;
+					found = true;
+				}
+			}
+			if (!found)
+			{
+				std::cerr << "parseAccessMode: Unknown access mode \"" << std::string(str, len) << "\" for param " << param_name << std::endl;
+			}
+		}
+		str += (str[len] == ',' ? len + 1 : len);
+	}
+	return access_mode;
+}
+
+/// Parse a comma separated list of alarm fields e.g. "Hi,HiHi" into a combination of #NvAlarmField, "none" gives 0
+/// and an empty string -1 meaning the alarm fields should be discovered by browsing
+int parseAlarmFields(const char* alarms_str, const std::string& param_name)
+{
+	static const struct { const char* name; NvAlarmField field; } fields[] = { 
+	    { "Hi", NvAlarmHi }, { "HiHi", NvAlarmHiHi }, { "Lo", NvAlarmLo }, { "LoLo", NvAlarmLoLo } };
+	if (*alarms_str == '\0')
+	{
+		return -1;
+	}
+	int alarms = 0;
+	const char* str = alarms_str;
+	while(*str != '\0')
+	{
+		size_t len = strcspn(str, ",");
+		if (len > 0 && !(len == 4 && strncmp(str, "none", len) == 0))
+		{
+			bool found = false;
+			for(size_t i=0; i<sizeof(fields) / sizeof(fields[0]) && !found; ++i)
+			{
+				if (strlen(fields[i].name) == len && strncmp(str, fields[i].name, len) == 0)
+				{
+					alarms |= fields[i].field;
+					found = true;
+				}
+			}
+			if (!found)
+			{
+				std::cerr << "parseAlarmFields: Unknown alarm field \"" << std::string(str, len) << "\" for param " << param_name << std::endl;
+			}
+		}
+		str += (str[len] == ',' ? len + 1 : len);
+	}
+	return alarms;
+}
+
+/// convert the \a ts_source attribute to an #NvTsSource, an empty string gives #NvTsDefault
+static NvTsSource parseTsSource(const char* ts_source_str, const std::string& param_name)
+{
+	static const struct { const char* name; NvTsSource source; } sources[] = { 
+	    { "server", NvTsServer }, { "local_receive", NvTsLocalReceive }, { "linked", NvTsLinked }, { "embedded", NvTsEmbedded }, { "none", NvTsNone } };
+	if (*ts_source_str == '\0')
+	{
+		return NvTsDefault;
+	}
+	for(size_t i=0; i<sizeof(sources) / sizeof(sources[0]); ++i)
+	{
+		if (!strcmp(ts_source_str, sources[i].name))
+		{
+			return sources[i].source;
+		}
+	}
+	std::cerr << "parseTsSource: Unknown ts_source \"" << ts_source_str << "\" for param " << param_name << std::endl;
+	return NvTsDefault;
+}
+
+/// walk the XML document once, collecting the parameters of every section
+static void parseConfig(const pugi::xml_document& doc, NvConfigFile& config)
+{
+	for(pugi::xml_node section = doc.child("netvar").child("section"); section; section = section.next_sibling("section"))
+	{
+		NvSectionConfig& params = config.sections[section.attribute("name").value()];
+		for(pugi::xml_node node = section.child("param"); node; node = node.next_sibling("param"))
+		{
+			params.push_back(NvParamConfig());
+			NvParamConfig& pc = params.back();
+			pc.name = node.attribute("name").value();
+			pc.type = node.attribute("type").value();
+			pc.netvar = node.attribute("netvar").value();
+			pc.ts_param = node.attribute("ts_param").value();
+			pc.access = parseAccessMode(node.attribute("access").value(), pc.name);
+			pc.field = (*node.attribute("field").value() != '\0' ? node.attribute("field").as_int() : -1);
+			pc.with_ts = !strcmp(node.attribute("with_ts").value(), "true");
+			pc.max_rate = node.attribute("max_rate").as_double(0.0);
+			pc.max_age = node.attribute("max_age").as_double(0.0);
+			pc.poll_ms = node.attribute("poll_ms").as_int(0);
+			pc.stats = node.attribute("stats").as_bool(false);
+			pc.preview = node.attribute("preview").as_int(0);
+			pc.shape = node.attribute("shape").as_bool(false);
+			pc.transpose = node.attribute("transpose").as_bool(false);
+			pc.alarms = parseAlarmFields(node.attribute("alarms").value(), pc.name);
+			pc.ts_source = parseTsSource(node.attribute("ts_source").value(), pc.name);
+			pc.correct_clock = node.attribute("correct_clock").as_bool(false);
+			pc.latency = node.attribute("latency").as_bool(false);
+			pc.write_through = node.attribute("write_through").as_bool(false);
+		}
+		for(pugi::xml_node node = section.child("paramgroup"); node; node = node.next_sibling("paramgroup"))
+		{
+			NvSectionGroupConfig& groups = config.groups[section.attribute("name").value()];
+			groups.push_back(NvParamGroupConfig());
+			NvParamGroupConfig& gc = groups.back();
+			gc.netvar = node.attribute("netvar").value();
+			gc.prefix = node.attribute("prefix").value();
+			gc.pattern = node.attribute("pattern").as_string("*");
+			gc.type = node.attribute("type").value();
+			gc.cache = node.attribute("cache").value();
+			gc.access = parseAccessMode(node.attribute("access").value(), gc.netvar);
+			gc.max_rate = node.attribute("max_rate").as_double(0.0);
+		}
+	}
+}
+
+/// Return the parsed contents of the XML file \a path. The file is only parsed if it is not currently loaded, 
+/// it has been modified since it was last parsed, or \a force is true; otherwise the previously parsed result is returned.
+/// The cache only holds weak references, so a parsed file is freed once no NetShrVarInterface is using it.
+std::shared_ptr<const NvConfigFile> loadConfigFile(const std::string& path, bool force)
+{
+	typedef std::map< std::string, std::weak_ptr<const NvConfigFile> > cache_t;
+	static cache_t cache;
+	static epicsMutex cache_lock;
+	epicsGuard<epicsMutex> _lock(cache_lock);
+	struct stat st;
+	time_t mtime = (stat(path.c_str(), &st) == 0 ? st.st_mtime : 0);
+	cache_t::iterator it = cache.find(path);
+	std::shared_ptr<const NvConfigFile> cached = (it != cache.end() ? it->second.lock() : std::shared_ptr<const NvConfigFile>());
+	if (!force && cached && cached->mtime == mtime)
+	{
+		return cached;
+	}
+	pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_file(path.c_str());
+	if (!result)
+	{
+		throw std::runtime_error("Cannot load XML \"" + path + "\": load failure: " + result.description());
+	}
+	std::shared_ptr<NvConfigFile> config(new NvConfigFile);
+	config->path = path;
+	config->mtime = mtime;
+	parseConfig(doc, *config);
+	cache[path] = config;
+	return config;
+}
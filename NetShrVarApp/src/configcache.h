@@ -0,0 +1,119 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file configcache.h Header for loading and caching the parsed contents of @link netvarconfig.xml @endlink files.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#ifndef CONFIGCACHE_H
+#define CONFIGCACHE_H
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <epicsMutex.h>
+#include <macLib.h>
+
+/// possible access modes to a network shared variable, combined in NvParamConfig::access
+enum NvAccessMode { NvAccessRead=0x1, NvAccessWrite=0x2, NvAccessBufferedRead=0x4, NvAccessBufferedWrite=0x8, NvAccessSingleRead=0x10 };
+
+/// LabVIEW shared variable alarm fields, combined in NvParamConfig::alarms
+enum NvAlarmField { NvAlarmHi=0x1, NvAlarmHiHi=0x2, NvAlarmLo=0x4, NvAlarmLoLo=0x8 };
+
+/// where the EPICS timestamp of a parameter update comes from, NvParamConfig::ts_source
+enum NvTsSource { NvTsDefault=0, NvTsServer, NvTsLocalReceive, NvTsLinked, NvTsEmbedded, NvTsNone };
+
+/// settings of a  <param>  element from the XML file 
+struct NvParamConfig
+{
+	std::string name; ///< asyn parameter name
+	std::string type; ///< type as specified in the XML file e.g. float64array
+	std::string netvar; ///< path to network shared variable, before any macro expansion
+	std::string ts_param; ///< parameter that is timestamp source
+	unsigned access; ///< combination of #NvAccessMode
+	int field; ///< if we refer to a struct, this is the index of the field (starting at 0), otherwise it is -1 
+	bool with_ts; ///< timestamp is encoded in first few array elements
+	double max_rate; ///< maximum rate (Hz) at which subscriber updates are processed, 0 means no limit
+	double max_age; ///< for single read access, how long (seconds) a value read can be reused for, 0 means always read
+	int poll_ms; ///< for single read access, period (ms) at which the driver reads the value itself, 0 for none
+	bool stats; ///< create derived array statistics parameters
+	int preview; ///< number of points in derived array preview parameter, 0 for none
+	bool shape; ///< create derived array dimension parameters
+	bool transpose; ///< transpose a two dimensional array before publishing it
+	int alarms; ///< combination of #NvAlarmField for the alarm fields to connect to, or -1 to look for them by browsing
+	NvTsSource ts_source; ///< where the timestamp comes from, #NvTsDefault to decide from #ts_param and #with_ts
+	bool correct_clock; ///< adjust server timestamps by the measured offset between the server clock and ours
+	bool latency; ///< measure subscriber update latencies and create derived latency parameters
+	bool write_through; ///< a successful write updates the parameter immediately and its subscriber echo is suppressed
+	NvParamConfig() : access(0), field(-1), with_ts(false), max_rate(0.0), max_age(0.0), poll_ms(0), stats(false), preview(0), shape(false), 
+	    transpose(false), alarms(-1), ts_source(NvTsDefault), correct_clock(false), latency(false), write_through(false) { }
+};
+
+typedef std::vector<NvParamConfig> NvSectionConfig; ///< parameters of a  <section>  in the order they appear in the file 
+
+/// settings of a  <paramgroup>  element from the XML file, which creates parameters for all the variables found
+/// by browsing a process or folder
+struct NvParamGroupConfig
+{
+	std::string netvar; ///< path to process or folder to browse, before any macro expansion
+	std::string prefix; ///< prepended to the variable name to give the asyn parameter name
+	std::string pattern; ///< only variables whose name matches this wildcard pattern are used
+	std::string type; ///< asyn parameter type to use, empty to infer from the variable type
+	std::string cache; ///< file to cache browse results in, before any macro expansion, empty for no cache
+	unsigned access; ///< combination of #NvAccessMode
+	double max_rate; ///< as NvParamConfig::max_rate
+	NvParamGroupConfig() : access(0), max_rate(0.0) { }
+};
+
+typedef std::vector<NvParamGroupConfig> NvSectionGroupConfig; ///< parameter groups of a  <section> 
+
+/// parsed contents of an XML configuration file
+struct NvConfigFile
+{
+	std::string path; ///< path to XML file
+	time_t mtime; ///< modification time of file when it was parsed
+	std::map<std::string,NvSectionConfig> sections; ///< parameters of each section, keyed by section name
+	std::map<std::string,NvSectionGroupConfig> groups; ///< parameter groups of each section, keyed by section name
+	const NvSectionConfig* section(const std::string& name) const
+	{
+		std::map<std::string,NvSectionConfig>::const_iterator it = sections.find(name);
+		return (it != sections.end() ? &(it->second) : NULL);
+	}
+	const NvSectionGroupConfig* sectionGroups(const std::string& name) const
+	{
+		std::map<std::string,NvSectionGroupConfig>::const_iterator it = groups.find(name);
+		return (it != groups.end() ? &(it->second) : NULL);
+	}
+};
+
+/// A snapshot of the process environment as macro definitions, used to expand macros in the XML file
+/// as they were when NetShrVarConfigure() was called 
+struct NvEnvSnapshot
+{
+	MAC_HANDLE* mac_env;
+	epicsMutex lock; ///< macLib handles are not safe to use from several threads at once
+	NvEnvSnapshot() : mac_env(NULL) { }
+	~NvEnvSnapshot() 
+	{ 
+	    if (mac_env != NULL) 
+		{
+			macDeleteHandle(mac_env);
+		}
+	}
+private:
+	NvEnvSnapshot(const NvEnvSnapshot&);
+	NvEnvSnapshot& operator=(const NvEnvSnapshot&);
+};
+
+extern std::shared_ptr<NvEnvSnapshot> getEnvSnapshot();
+extern int parseAlarmFields(const char* alarms_str, const std::string& param_name);
+extern unsigned parseAccessMode(const char* access_str, const std::string& param_name);
+extern std::shared_ptr<const NvConfigFile> loadConfigFile(const std::string& path, bool force);
+
+#endif /* CONFIGCACHE_H */
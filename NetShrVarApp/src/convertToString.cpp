@@ -32,6 +32,12 @@ std::string convertToString(double t)
 	return buffer;
 }
 
+template<>
+std::string convertToString(float t)
+{
+	return convertToString(static_cast<double>(t));
+}
+
 template<>
 std::string convertToString(int t)
 {
@@ -39,3 +45,19 @@ std::string convertToString(int t)
 	snprintf(buffer, sizeof(buffer), "%d", t);
 	return buffer;
 }
+
+template<>
+std::string convertToString(long long t)
+{
+	char buffer[30];
+	snprintf(buffer, sizeof(buffer), "%lld", t);
+	return buffer;
+}
+
+template<>
+std::string convertToString(unsigned long long t)
+{
+	char buffer[30];
+	snprintf(buffer, sizeof(buffer), "%llu", t);
+	return buffer;
+}
@@ -0,0 +1,271 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file dispatcher.cpp Process network shared variable subscriber updates on a pool of worker threads, see #NvDispatcher
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <sstream>
+#include <iostream>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#include <cvirte.h>
+#include <userint.h>
+#include <cvinetv.h>
+
+#include "dispatcher.h"
+
+/// \param[in] name used to name the worker threads
+/// \param[in] nthreads number of worker threads to create, at least one is always created
+/// \param[in] func called on a worker thread for each update passed to dispatch()
+/// \param[in] queue_size maximum number of updates waiting for each worker thread
+/// \param[in] policy which update to discard when a queue is full
+NvDispatcher::NvDispatcher(const std::string& name, int nthreads, DispatchFunc func, size_t queue_size, OverflowPolicy policy) : 
+                   m_name(name), m_func(func), m_policy(policy)
+{
+	if (nthreads < 1)
+	{
+		nthreads = 1;
+	}
+	for(int i=0; i<nthreads; ++i)
+	{
+		Worker* worker = new Worker(this, queue_size);
+		std::ostringstream thread_name;
+		thread_name << "NSV" << name << i;
+		if (epicsThreadCreate(thread_name.str().c_str(), epicsThreadPriorityMedium,
+		                      epicsThreadGetStackSize(epicsThreadStackMedium), workerThread, worker) == 0)
+		{
+			std::cerr << "NvDispatcher: epicsThreadCreate failure for " << thread_name.str() << std::endl;
+			delete worker;
+			continue;
+		}
+		m_workers.push_back(worker);
+	}
+	std::cerr << "NvDispatcher: started " << m_workers.size() << " worker threads for " << name << std::endl;
+}
+
+NvDispatcher::~NvDispatcher()
+{
+	stop();
+	for(size_t i=0; i<m_workers.size(); ++i)
+	{
+		delete m_workers[i];
+	}
+}
+
+/// queue \a data to be processed by calling our DispatchFunc with \a arg on the worker thread selected by \a key.
+/// \a slot must be the same for every update with this \a key, if it already holds an update waiting to be processed 
+/// one of the two is discarded according to our OverflowPolicy. We take ownership of \a data, \a t_receive is passed 
+/// on to the DispatchFunc
+void NvDispatcher::dispatch(size_t key, Slot& slot, void* arg, CNVData data, epicsUInt64 t_receive)
+{
+	if (m_workers.size() == 0)
+	{
+		(*m_func)(arg, data, t_receive);  // no threads, so process directly
+		return;
+	}
+	Worker* worker = m_workers[key % m_workers.size()];
+	Job* job = new Job(arg, data, t_receive);
+	if (m_policy == DropNewest)
+	{
+		if (!setJobIfEmpty(worker, slot, job))  // keep the update already waiting
+		{
+			++(worker->n_dropped);
+			disposeJob(job);
+			return;
+		}
+	}
+	else
+	{
+		Job* old_job = exchangeJob(worker, slot, job);
+		if (old_job != NULL)  // slot is already queued, just replace the update waiting in it
+		{
+			++(worker->n_dropped);
+			disposeJob(old_job);
+			return;
+		}
+	}
+	if (!push(worker, &slot))  // only if more keys than the queue size have an update waiting
+	{
+		++(worker->n_dropped);
+		disposeJob(exchangeJob(worker, slot, NULL));
+		return;
+	}
+	++(worker->n_queued);
+	worker->work.signal();
+}
+
+/// add \a slot to the queue for \a worker, returns false if the queue is full
+bool NvDispatcher::push(Worker* worker, Slot* slot)
+{
+#ifdef NSV_NO_LFQUEUE
+	epicsGuard<epicsMutex> _lock(worker->lock);
+	worker->jobs.push_back(slot);
+	return true;
+#else
+	return worker->jobs.push(slot);
+#endif
+}
+
+/// take the oldest slot from the queue for \a worker, returns false if the queue is empty
+bool NvDispatcher::pop(Worker* worker, Slot*& slot)
+{
+#ifdef NSV_NO_LFQUEUE
+	epicsGuard<epicsMutex> _lock(worker->lock);
+	if (worker->jobs.empty())
+	{
+		return false;
+	}
+	slot = worker->jobs.front();
+	worker->jobs.pop_front();
+	return true;
+#else
+	return worker->jobs.pop(slot);
+#endif
+}
+
+/// put \a job (which may be NULL) in \a slot and return the job previously there
+NvDispatcher::Job* NvDispatcher::exchangeJob(Worker* worker, Slot& slot, Job* job)
+{
+#ifdef NSV_NO_LFQUEUE
+	epicsGuard<epicsMutex> _lock(worker->lock);
+	Job* old_job = slot.m_job;
+	slot.m_job = job;
+	return old_job;
+#else
+	(void)worker;  // only needed for its lock without the lock free queue
+	return slot.m_job.exchange(job);
+#endif
+}
+
+/// put \a job in \a slot if it is empty, returns false if \a slot already holds a job
+bool NvDispatcher::setJobIfEmpty(Worker* worker, Slot& slot, Job* job)
+{
+#ifdef NSV_NO_LFQUEUE
+	epicsGuard<epicsMutex> _lock(worker->lock);
+	if (slot.m_job != NULL)
+	{
+		return false;
+	}
+	slot.m_job = job;
+	return true;
+#else
+	(void)worker;  // only needed for its lock without the lock free queue
+	Job* expected = NULL;
+	return slot.m_job.compare_exchange_strong(expected, job);
+#endif
+}
+
+/// discard an update that will not be processed
+void NvDispatcher::disposeJob(Job* job)
+{
+	if (job != NULL)
+	{
+		CNVDisposeData(job->data);
+		delete job;
+	}
+}
+
+/// ask all worker threads to exit and wait for them to do so, any updates still queued are discarded
+void NvDispatcher::stop()
+{
+	for(size_t i=0; i<m_workers.size(); ++i)
+	{
+		Worker* worker = m_workers[i];
+		{
+			epicsGuard<epicsMutex> _lock(worker->lock);
+			if (worker->stopping)
+			{
+				continue;
+			}
+			worker->stopping = true;
+		}
+		worker->work.signal();
+		worker->done.wait();
+	}
+}
+
+/// wait until the updates queued before we were called have been processed, e.g. so the item an update refers to 
+/// can be changed once its connections have been closed. Returns early if the workers are stopping
+void NvDispatcher::flush()
+{
+	for(size_t i=0; i<m_workers.size(); ++i)
+	{
+		Worker* worker = m_workers[i];
+		unsigned long n_queued = worker->n_queued;
+		while(static_cast<long>(worker->n_done - n_queued) < 0)  // allow for wrap around
+		{
+			{
+				epicsGuard<epicsMutex> _lock(worker->lock);
+				if (worker->stopping)
+				{
+					return;
+				}
+			}
+			epicsThreadSleep(0.01);
+		}
+	}
+}
+
+void NvDispatcher::workerThread(void* arg)
+{
+	Worker* worker = static_cast<Worker*>(arg);
+	worker->parent->run(worker);
+}
+
+void NvDispatcher::run(Worker* worker)
+{
+	Slot* slot;
+	Job* job;
+	bool stopping = false;
+	while(!stopping)
+	{
+		worker->work.wait();
+		{
+			epicsGuard<epicsMutex> _lock(worker->lock);
+			stopping = worker->stopping;
+		}
+		while(!stopping && pop(worker, slot))
+		{
+			if ( (job = exchangeJob(worker, *slot, NULL)) != NULL )
+			{
+				(*m_func)(job->arg, job->data, job->t_receive);
+				delete job;
+				++(worker->n_processed);
+			}
+			++(worker->n_done);
+		}
+	}
+	while(pop(worker, slot))
+	{
+		disposeJob(exchangeJob(worker, *slot, NULL));
+		++(worker->n_done);
+	}
+	worker->done.signal();
+}
+
+/// helper for asyn driver report function
+void NvDispatcher::report(FILE* fp)
+{
+	fprintf(fp, "Subscriber update dispatcher \"%s\": %d worker threads, %s update kept when one is already waiting\n", m_name.c_str(), 
+	    numberOfThreads(), (m_policy == DropNewest ? "waiting" : "newest"));
+	for(size_t i=0; i<m_workers.size(); ++i)
+	{
+		Worker* worker = m_workers[i];
+		unsigned long n_queued = worker->n_queued, n_processed = worker->n_processed, n_dropped = worker->n_dropped;
+		fprintf(fp, "  Worker %d: %lu updates queued, %lu processed, %lu discarded\n", static_cast<int>(i), n_queued, n_processed, n_dropped);
+	}
+}
@@ -0,0 +1,115 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file dispatcher.h Header for #NvDispatcher, a pool of threads processing network shared variable subscriber updates.
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#ifndef DISPATCHER_H
+#define DISPATCHER_H
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+
+#include <cvinetv.h>
+
+#include "lfqueue.h"
+
+/// Process subscriber updates on a pool of worker threads rather than on the NI callback thread. Each update is
+/// queued to a worker chosen from a key (e.g. the asyn parameter index) so all updates for the same key are processed,
+/// in the order they arrived, by the same thread. Updates for different keys can then be decoded in parallel.
+/// At most one update per key waits to be processed, it is kept in a #Slot owned by the caller and only the slot is 
+/// queued. An update arriving for a key that already has one waiting replaces it (latest wins), or with #DropNewest
+/// is discarded, so a busy variable can never push out the only update of another. Each worker has a bounded lock free
+/// queue of slots (see #NvBoundedQueue) so the NI callback thread only has to queue an update and return. If the 
+/// compiler does not have <atomic> an unbounded queue and the slots are protected by a mutex instead. 
+class NvDispatcher
+{
+	struct Job;
+public:
+	typedef void (*DispatchFunc)(void* arg, CNVData data, epicsUInt64 t_receive); ///< called on a worker thread to process \a data, which it takes ownership of
+	enum OverflowPolicy { DropOldest=0, DropNewest=1 }; ///< which update to discard when another arrives for a key that already has one waiting
+	/// The update waiting to be processed for a key. The caller of dispatch() owns one of these per key and passes it with every
+	/// update for that key, it must not be destroyed while an update is waiting (see flush()). 
+	class Slot
+	{
+	public:
+		Slot() : m_job(NULL) { }
+	private:
+		friend class NvDispatcher;
+#ifdef NSV_NO_LFQUEUE
+		Job* m_job; ///< protected by the worker lock 
+#else
+		std::atomic<Job*> m_job;
+#endif
+		Slot(const Slot&);
+		Slot& operator=(const Slot&);
+	};
+	NvDispatcher(const std::string& name, int nthreads, DispatchFunc func, size_t queue_size = 1024, OverflowPolicy policy = DropOldest);
+	~NvDispatcher();
+	void dispatch(size_t key, Slot& slot, void* arg, CNVData data, epicsUInt64 t_receive);
+	void stop();
+	void flush();
+	int numberOfThreads() const { return static_cast<int>(m_workers.size()); }
+	void report(FILE* fp);
+private:
+	struct Job
+	{
+		void* arg;
+		CNVData data;
+		epicsUInt64 t_receive; ///< epicsMonotonicGet() when the update was received
+		Job(void* arg_, CNVData data_, epicsUInt64 t_receive_) : arg(arg_), data(data_), t_receive(t_receive_) { }
+	};
+	/// a worker thread and the queue of slots with an update waiting for it
+	struct Worker
+	{
+		NvDispatcher* parent;
+#ifdef NSV_NO_LFQUEUE
+		std::deque<Slot*> jobs; ///< slots with an update waiting to be processed, protected by #lock
+		unsigned long n_queued; ///< number of updates queued
+		unsigned long n_done; ///< number of queued slots taken by the worker and finished with
+		unsigned long n_processed; ///< number of updates processed
+		unsigned long n_dropped; ///< number of updates discarded as another was waiting for the same key
+#else
+		NvBoundedQueue<Slot*> jobs; ///< slots with an update waiting to be processed
+		std::atomic<unsigned long> n_queued; ///< number of updates queued
+		std::atomic<unsigned long> n_done; ///< number of queued slots taken by the worker and finished with
+		std::atomic<unsigned long> n_processed; ///< number of updates processed
+		std::atomic<unsigned long> n_dropped; ///< number of updates discarded as another was waiting for the same key, or the queue was full
+#endif
+		epicsMutex lock;
+		epicsEvent work; ///< signalled when a job is queued or we are asked to stop
+		epicsEvent done; ///< signalled by the worker thread when it exits
+		bool stopping;
+		Worker(NvDispatcher* parent_, size_t queue_size) : parent(parent_),
+#ifndef NSV_NO_LFQUEUE
+		    jobs(queue_size),
+#endif
+		    n_queued(0), n_done(0), n_processed(0), n_dropped(0), stopping(false) { }
+	};
+	std::string m_name;
+	std::vector<Worker*> m_workers;
+	DispatchFunc m_func;
+	OverflowPolicy m_policy;
+	bool push(Worker* worker, Slot* slot);
+	bool pop(Worker* worker, Slot*& slot);
+	Job* exchangeJob(Worker* worker, Slot& slot, Job* job);
+	bool setJobIfEmpty(Worker* worker, Slot& slot, Job* job);
+	static void disposeJob(Job* job);
+	static void workerThread(void* arg);
+	void run(Worker* worker);
+	NvDispatcher(const NvDispatcher&);
+	NvDispatcher& operator=(const NvDispatcher&);
+};
+
+#endif /* DISPATCHER_H */
@@ -0,0 +1,93 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file latency.h Histogram of update latencies, see #LatencyHistogram
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdio.h>
+
+/// Histogram of latencies (in seconds) with 1-2-5 bins from 100us to 5s plus an overflow bin. Values are only
+/// added from the one thread that processes updates for a parameter, reading for a report is not synchronised
+/// so may be slightly inconsistent.
+class LatencyHistogram
+{
+public:
+	enum { NBins = 16 };
+	LatencyHistogram() : m_n(0), m_min(0.0), m_max(0.0), m_sum(0.0), m_last(0.0)
+	{
+		for(int i=0; i<NBins; ++i)
+		{
+			m_counts[i] = 0;
+		}
+	}
+	void add(double latency)
+	{
+		int i = 0;
+		while(i < NBins - 1 && latency > binLimit(i))
+		{
+			++i;
+		}
+		++(m_counts[i]);
+		if (m_n == 0 || latency < m_min)
+		{
+			m_min = latency;
+		}
+		if (m_n == 0 || latency > m_max)
+		{
+			m_max = latency;
+		}
+		++m_n;
+		m_sum += latency;
+		m_last = latency;
+	}
+	double last() const { return m_last; } ///< most recent latency added
+	/// helper for asyn driver report function
+	void report(FILE* fp, const char* title) const
+	{
+		if (m_n == 0)
+		{
+			return;
+		}
+		fprintf(fp, "  %s latency: %lu updates, min %.3f ms, mean %.3f ms, max %.3f ms\n", title, m_n, m_min * 1e3,
+		    m_sum * 1e3 / m_n, m_max * 1e3);
+		fprintf(fp, "   ");
+		for(int i=0; i<NBins; ++i)
+		{
+			if (m_counts[i] == 0)
+			{
+				;
+			}
+			else if (i < NBins - 1)
+			{
+				fprintf(fp, " <=%gms:%lu", binLimit(i) * 1e3, m_counts[i]);
+			}
+			else
+			{
+				fprintf(fp, " >%gms:%lu", binLimit(i - 1) * 1e3, m_counts[i]);
+			}
+		}
+		fprintf(fp, "\n");
+	}
+private:
+	unsigned long m_counts[NBins];
+	unsigned long m_n;
+	double m_min;
+	double m_max;
+	double m_sum;
+	double m_last;
+	/// upper limit (seconds) of bin \a i, the last bin has no upper limit
+	static double binLimit(int i)
+	{
+		static const double limits[NBins - 1] = { 1e-4, 2e-4, 5e-4, 1e-3, 2e-3, 5e-3, 1e-2, 2e-2, 5e-2, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0 };
+		return limits[i];
+	}
+};
+
+#endif /* LATENCY_H */
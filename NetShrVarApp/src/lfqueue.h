@@ -0,0 +1,133 @@
+/*************************************************************************\
+* Copyright (c) 2013 Science and Technology Facilities Council (STFC), GB.
+* All rights reverved.
+* This file is distributed subject to a Software License Agreement found
+* in the file LICENSE.txt that is included with this distribution.
+\*************************************************************************/
+
+/// @file lfqueue.h Bounded lock free queue, see #NvBoundedQueue
+/// @author Freddie Akeroyd, STFC ISIS Facility, GB
+
+#ifndef LFQUEUE_H
+#define LFQUEUE_H
+
+#include <stddef.h>
+
+/// pre VS2012 does not have <atomic>, see NSV_EMULATE_ATOMIC in NetShrVarInterface.h
+#if defined(_WIN32) && defined(_MSC_VER) && _MSC_VER < 1700
+#define NSV_NO_LFQUEUE
+#else
+
+#include <atomic>
+
+/// A bounded lock free multi producer queue based on Dmitry Vyukov's array queue. Each cell carries a sequence
+/// number that says whether it is ready to be written or read for the current lap of the ring, so producers
+/// and consumers only contend on their own position counter. Pops are also safe from several threads.
+template <typename T>
+class NvBoundedQueue
+{
+public:
+	/// \param[in] size maximum number of entries, rounded up to a power of two
+	explicit NvBoundedQueue(size_t size) : m_mask(0), m_enqueue_pos(0), m_dequeue_pos(0)
+	{
+		size_t n = 2;
+		while(n < size)
+		{
+			n *= 2;
+		}
+		m_mask = n - 1;
+		m_buffer = new Cell[n];
+		for(size_t i=0; i<n; ++i)
+		{
+			m_buffer[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+	~NvBoundedQueue() { delete[] m_buffer; }
+	/// add \a data to the queue, returns false if the queue is full
+	bool push(const T& data)
+	{
+		Cell* cell;
+		size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			cell = &(m_buffer[pos & m_mask]);
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+			if (diff == 0)
+			{
+				if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;  // full
+			}
+			else
+			{
+				pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = data;
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+	/// remove the oldest entry from the queue into \a data, returns false if the queue is empty
+	bool pop(T& data)
+	{
+		Cell* cell;
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			cell = &(m_buffer[pos & m_mask]);
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;  // empty
+			}
+			else
+			{
+				pos = m_dequeue_pos.load(std::memory_order_relaxed);
+			}
+		}
+		data = cell->data;
+		cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+	/// number of entries in the queue, only approximate if other threads are using the queue
+	size_t size() const
+	{
+		size_t enq = m_enqueue_pos.load(std::memory_order_relaxed), deq = m_dequeue_pos.load(std::memory_order_relaxed);
+		return (enq > deq ? enq - deq : 0);
+	}
+	size_t capacity() const { return m_mask + 1; }
+private:
+	struct Cell
+	{
+		std::atomic<size_t> seq;
+		T data;
+	};
+	static const size_t cacheline = 64;
+	Cell* m_buffer;
+	size_t m_mask;
+	char m_pad0[cacheline];  ///< keep producer and consumer positions on separate cache lines
+	std::atomic<size_t> m_enqueue_pos;
+	char m_pad1[cacheline];
+	std::atomic<size_t> m_dequeue_pos;
+	char m_pad2[cacheline];
+	NvBoundedQueue(const NvBoundedQueue&);
+	NvBoundedQueue& operator=(const NvBoundedQueue&);
+};
+
+#endif /* pre VS2012 */
+
+#endif /* LFQUEUE_H */
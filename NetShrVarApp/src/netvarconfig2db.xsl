@@ -116,7 +116,26 @@ record(longout, "$(P)<xsl:value-of select="$asyn_param"/>")
 }
 
 </xsl:when>
-<xsl:when test="@type = 'float64'">
+<xsl:when test="@type = 'int64' or @type = 'uint64'">
+# Read <xsl:value-of select="$nsv_comment"/>
+record(int64in, "$(P)<xsl:value-of select="$asyn_param"/>_RBV")
+{
+    field(DESC, "<xsl:value-of select="$nsv_desc"/>")
+    field(DTYP, "<xsl:value-of select="$asyn_type"/>")
+    field(INP,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
+    field(SCAN, "I/O Intr")
+}
+
+# Write <xsl:value-of select="$nsv_comment"/>
+record(int64out, "$(P)<xsl:value-of select="$asyn_param"/>")
+{
+    field(DESC, "<xsl:value-of select="$nsv_desc"/>")
+    field(DTYP, "<xsl:value-of select="$asyn_type"/>")
+    field(OUT,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
+}
+
+</xsl:when>
+<xsl:when test="@type = 'float64' or @type = 'float32'">
 # Read <xsl:value-of select="$nsv_comment"/>
 record(ai, "$(P)<xsl:value-of select="$asyn_param"/>_RBV")
 {
@@ -185,6 +204,54 @@ record(waveform, "$(P)<xsl:value-of select="$asyn_param"/>")
     field(INP,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
 }
 
+</xsl:when>
+<xsl:when test="@type = 'longstring'">
+## A longstring is passed as a character array, so is not limited to 40 characters - adjust NELM if necessary
+
+# Read <xsl:value-of select="$nsv_comment"/>
+record(waveform, "$(P)<xsl:value-of select="$asyn_param"/>_RBV")
+{
+    field(DESC, "<xsl:value-of select="$nsv_desc"/>")
+    field(DTYP, "<xsl:value-of select="$asyn_type"/>In")
+	field(FTVL, "CHAR")
+	field(NELM, 4096)
+    field(INP,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
+    field(SCAN, "I/O Intr")
+}
+
+# Write <xsl:value-of select="$nsv_comment"/>
+record(waveform, "$(P)<xsl:value-of select="$asyn_param"/>")
+{
+    field(DESC, "<xsl:value-of select="$nsv_desc"/>")
+    field(DTYP, "<xsl:value-of select="$asyn_type"/>Out")
+	field(FTVL, "CHAR")
+	field(NELM, 4096)
+    field(INP,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
+}
+
+</xsl:when>
+<xsl:when test="@type = 'int64array' or @type = 'uint64array'">
+# Read <xsl:value-of select="$nsv_comment"/>
+record(waveform, "$(P)<xsl:value-of select="$asyn_param"/>_RBV")
+{
+    field(DESC, "<xsl:value-of select="$nsv_desc"/>")
+    field(DTYP, "<xsl:value-of select="$asyn_type"/>In")
+	field(FTVL, "INT64")
+	field(NELM, 1000)
+    field(INP,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
+    field(SCAN, "I/O Intr")
+}
+
+# Write <xsl:value-of select="$nsv_comment"/>
+record(waveform, "$(P)<xsl:value-of select="$asyn_param"/>")
+{
+    field(DESC, "<xsl:value-of select="$nsv_desc"/>")
+    field(DTYP, "<xsl:value-of select="$asyn_type"/>Out")
+	field(FTVL, "INT64")
+	field(NELM, 1000)
+    field(INP,  "@asyn(nsv,0,0)<xsl:value-of select="$asyn_param"/>")
+}
+
 </xsl:when>
 <xsl:when test="@type = 'boolean'">
     <xsl:variable name="zname">
@@ -283,12 +350,18 @@ record(bo, "$(P)<xsl:value-of select="$asyn_param"/>")
         <xsl:when test="$vartype = 'int32'">asynInt32</xsl:when>
         <xsl:when test="$vartype = 'boolean'">asynInt32</xsl:when>
         <xsl:when test="$vartype = 'float64'">asynFloat64</xsl:when>
+        <xsl:when test="$vartype = 'float32'">asynFloat64</xsl:when>
         <xsl:when test="$vartype = 'string'">asynOctet</xsl:when>
         <xsl:when test="$vartype = 'float64array'">asynFloat64Array</xsl:when>
         <xsl:when test="$vartype = 'float32array'">asynFloat32Array</xsl:when>
         <xsl:when test="$vartype = 'int32array'">asynInt32Array</xsl:when>
         <xsl:when test="$vartype = 'int16array'">asynInt16Array</xsl:when>
         <xsl:when test="$vartype = 'int8array'">asynInt8Array</xsl:when>
+        <xsl:when test="$vartype = 'longstring'">asynInt8Array</xsl:when>
+        <xsl:when test="$vartype = 'int64'">asynInt64</xsl:when>
+        <xsl:when test="$vartype = 'uint64'">asynInt64</xsl:when>
+        <xsl:when test="$vartype = 'int64array'">asynInt64Array</xsl:when>
+        <xsl:when test="$vartype = 'uint64array'">asynInt64Array</xsl:when>
 		<xsl:otherwise>invalid</xsl:otherwise>
 	</xsl:choose>
 	
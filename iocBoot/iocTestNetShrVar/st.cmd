@@ -21,8 +21,30 @@ TestNetShrVar_registerRecordDeviceDriver pdbbase
 ## pollPeriod    (100) is the interval (ms) at which the driver will pull
 ##               values from the client side buffer for variables
 ##               accessed via a BufferedReader connection
-## options       (0 below) is currently unused but would map to values
-##               in #NetShrVarOptions
+## options       (0 below) maps to values in #NetShrVarOptions, add them 
+##               together to combine. 2 (NVDispatchThreads) processes
+##               subscriber updates on a pool of worker threads, one per 
+##               CPU unless NETSHRVAR_DISPATCH_THREADS is set, so large
+##               arrays for different variables can be decoded in parallel.
+##               4 (NVPublisherThread) uses a single thread instead. Either 
+##               way the NI callback thread just queues the update. Only 
+##               one update per variable waits to be processed, a newer 
+##               update replaces it or if 8 (NVDropNewest) is also given is
+##               discarded. NETSHRVAR_QUEUE_SIZE (default 1024) is the number
+##               of variables that can be waiting per thread. Counts are 
+##               shown by asynReport
+## If NETSHRVAR_SNAPSHOT_DIR is set, parameter values are saved every 
+## NETSHRVAR_SNAPSHOT_PERIOD (default 10) seconds and at exit to the file
+## <configSection>.snap in this directory, and restored from it at startup 
+## with a UDF alarm until live data arrives. Initial reads of restored 
+## variables are then done in the background rather than delaying startup.
+## Records see restored values when first processed e.g. with PINI="YES"
+#epicsEnvSet("NETSHRVAR_SNAPSHOT_DIR", "$(TOP)/iocBoot/$(IOC)")
+## If a connection to a shared variable cannot be made it is retried in 
+## the background, after NETSHRVAR_RECONNECT_MIN (default 1) seconds and 
+## then with the delay doubling (plus some randomness) up to 
+## NETSHRVAR_RECONNECT_MAX (default 60) seconds. Set NETSHRVAR_RECONNECT_MAX
+## to 0 to not retry. Connection state and counts are shown by asynReport
 NetShrVarConfigure("nsv", "sec1", "$(TOP)/TestNetShrVarApp/src/netvarconfig.xml", 100, 0)
 
 ## Load our record instances - basic network shared variable access.
@@ -36,3 +58,9 @@ dbLoadRecords("db/TestNetShrVar.db","P=TEST:")
 
 cd ${TOP}/iocBoot/${IOC}
 iocInit
+
+## After editing the XML file, changes can be applied without restarting the IOC with
+##   NetShrVarReload("nsv")
+## Changed parameters are reconnected, removed ones disconnected (their records then get
+## an error) and removed ones that are put back are reconnected. Records bind to parameters
+## at iocInit, so parameters new to the file and changes of type are ignored until a restart.